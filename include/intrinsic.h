@@ -119,6 +119,59 @@ static __inline uint64_t rcr2(void) {
 	return val;
 }
 
+__attribute__((always_inline))
+static __inline uint64_t rcr0(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr0,%0" : "=r" (val));
+	return val;
+}
+
+__attribute__((always_inline))
+static __inline void lcr0(uint64_t val) {
+	__asm __volatile("movq %0, %%cr0" : : "r" (val) : "memory");
+}
+
+/* Control register 4 holds feature enables such as CR4.PCIDE.
+   See [IA32-v3a] 2.5 "Control Registers". */
+__attribute__((always_inline))
+static __inline uint64_t rcr4(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr4,%0" : "=r" (val));
+	return val;
+}
+
+__attribute__((always_inline))
+static __inline void lcr4(uint64_t val) {
+	__asm __volatile("movq %0, %%cr4" : : "r" (val) : "memory");
+}
+
+/* Executes CPUID for LEAF (and sub-leaf SUBLEAF) and stores the
+   four result registers. */
+__attribute__((always_inline))
+static __inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+		uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+	__asm __volatile("cpuid"
+			: "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+			: "a" (leaf), "c" (subleaf));
+}
+
+/* Invalidates TLB entries tagged with process-context identifier
+   PCID according to TYPE (0: the one for ADDR, 1: all of PCID).
+   See [IA32-v2a] "INVPCID--Invalidate Process-Context Identifier". */
+__attribute__((always_inline))
+static __inline void invpcid(uint64_t type, uint64_t pcid, uint64_t addr) {
+	struct { uint64_t pcid; uint64_t addr; } desc = { pcid, addr };
+	__asm __volatile("invpcid %0, %1" : : "m" (desc), "r" (type) : "memory");
+}
+
+/* Returns the processor's time-stamp counter. */
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
 __attribute__((always_inline))
 static __inline void write_msr(uint32_t ecx, uint64_t val) {
 	uint32_t edx, eax;
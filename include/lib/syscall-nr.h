@@ -36,6 +36,44 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MADVISE,                /* Advise on the use of a memory range. */
+	SYS_MSYNC,                  /* Write a file mapping back to its file. */
+	SYS_MEMINFO,                /* Report the memory usage of a process. */
+	SYS_SHM_MAP,                /* Map a named shared memory segment. */
+	SYS_SHM_UNLINK,             /* Remove the name of a segment. */
+	SYS_SPAWN,                  /* Start a new process running a program. */
+};
+
+/* Advice values for SYS_MADVISE. */
+enum {
+	MADV_NORMAL,                /* No special treatment. */
+	MADV_RANDOM,                /* Expect random page references. */
+	MADV_SEQUENTIAL,            /* Expect sequential page references. */
+	MADV_WILLNEED,              /* Will need these pages soon. */
+	MADV_DONTNEED,              /* Don't need these pages. */
+};
+
+/* Flags for SYS_MSYNC. */
+#define MS_ASYNC 1              /* Schedule the writes and return. */
+#define MS_INVALIDATE 2         /* Accepted; there is no other cached copy. */
+#define MS_SYNC 4               /* Write the pages before returning. */
+
+/* Process identifiers with a special meaning for SYS_MEMINFO. */
+#define MEMINFO_SELF 0          /* The calling process. */
+#define MEMINFO_ALL -1          /* All processes together. */
+
+/* Memory usage reported by SYS_MEMINFO.  Page counts, except for
+   the fault counts.  A frame shared by several processes (fork,
+   executable text) is counted once for each of them. */
+struct meminfo {
+	unsigned long rss_anon;     /* Resident anonymous pages. */
+	unsigned long rss_file;     /* Resident pages of file mappings. */
+	unsigned long swap;         /* Anonymous pages in swap. */
+	unsigned long committed;    /* Reserved writable anonymous pages. */
+	unsigned long minor_faults; /* Faults handled without disk reads. */
+	unsigned long major_faults; /* Faults that read a file or swap. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <syscall-nr.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -25,6 +26,7 @@ void halt(void) NO_RETURN;
 void exit(int status) NO_RETURN;
 pid_t fork(const char *thread_name);
 int exec(const char *file);
+pid_t spawn(const char *cmd_line);
 int wait(pid_t);
 bool create(const char *file, unsigned initial_size);
 bool remove(const char *file);
@@ -41,6 +43,11 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
+int madvise(void *addr, size_t length, int advice);
+int msync(void *addr, size_t length, int flags);
+int meminfo(pid_t pid, struct meminfo *info);
+void *shm_map(const char *name, size_t size, void *addr);
+int shm_unlink(const char *name);
 
 /* Project 4 only. */
 bool chdir(const char *dir);
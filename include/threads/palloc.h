@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -8,7 +9,8 @@
 enum palloc_flags {
 	PAL_ASSERT = 001,           /* Panic on failure. */
 	PAL_ZERO = 002,             /* Zero page contents. */
-	PAL_USER = 004              /* User page. */
+	PAL_USER = 004,             /* User page. */
+	PAL_NOWAIT = 010            /* Fail rather than wait for the pool. */
 };
 
 /* Maximum number of pages to put in user pool. */
@@ -17,7 +19,12 @@ extern size_t user_page_limit;
 uint64_t palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_huge_page (enum palloc_flags);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void *palloc_user_pool (size_t *page_cnt);
+bool palloc_zero_refill (void);
+size_t palloc_zero_cnt (enum palloc_flags);
+void palloc_print_stats (void);
 
 #endif /* threads/palloc.h */
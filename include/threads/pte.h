@@ -26,7 +26,24 @@
 #define PDPE(la) ((((uint64_t) (la)) >> PDPESHIFT) & 0x1FF)
 #define PDX(la)  ((((uint64_t) (la)) >> PDXSHIFT) & 0x1FF)
 #define PTX(la)  ((((uint64_t) (la)) >> PTXSHIFT) & 0x1FF)
-#define PTE_ADDR(pte) ((uint64_t) (pte) & ~0xFFF)
+#define PTE_ADDR(pte) ((uint64_t) (pte) & ~(0xFFFUL | PTE_CNT_MASK))
+
+/* An entry that points to a page table keeps the number of
+   non-zero entries in that table in bits 52:61, which the MMU
+   ignores.  See mmu.c. */
+#define PTE_CNT_SHIFT 52
+#define PTE_CNT_MASK  (0x3FFUL << PTE_CNT_SHIFT)
+#define PTE_CNT_ONE   (1UL << PTE_CNT_SHIFT)
+#define PTE_CNT(pte)  (((uint64_t) (pte) & PTE_CNT_MASK) >> PTE_CNT_SHIFT)
+
+/* A page directory entry with PTE_PS set maps a whole 2 MB page
+   instead of pointing to a page table.  Its frame address must be
+   2 MB aligned, so the low 21 bits hold flags (or are reserved). */
+#define HUGE_PGBITS  PDXSHIFT                   /* Number of offset bits. */
+#define HUGE_PGSIZE  (1UL << HUGE_PGBITS)       /* Bytes in a 2 MB page. */
+#define HUGE_PGMASK  (HUGE_PGSIZE - 1)          /* Offset bits (0:21). */
+#define HUGE_PGCNT   (HUGE_PGSIZE / PGSIZE)     /* 4 kB pages in a 2 MB page. */
+#define HUGE_PTE_ADDR(pde) ((uint64_t) (pde) & ~HUGE_PGMASK)
 
 /* The important flags are listed below.
    When a PDE or PTE is not "present", the other flags are
@@ -41,5 +58,6 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=2 MB page (PDEs only). */
 
 #endif /* threads/pte.h */
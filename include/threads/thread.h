@@ -149,6 +149,10 @@ struct thread
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
 	void *user_rsp;
+	/* NOTE: [VM] OOM killer가 고른 프로세스 - 다음 폴트나 시스템 콜에서 종료 */
+	bool oom_killed;
+	int64_t oom_kill_tick; /* OOM killer가 고른 시각 - OOM_WAIT 안에 종료하지 않으면 다른 프로세스를 고름 */
+	bool oom_wait;		   /* 다른 프로세스를 OOM으로 종료시켜 할당이 실패함 - 폴트가 락을 놓은 뒤 기다렸다가 다시 시도 */
 #endif
 
 	/* Owned by thread.c. */
@@ -168,6 +172,7 @@ void thread_tick(void);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
+typedef void thread_action_func(struct thread *t, void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
 
 void thread_block(void);
@@ -197,6 +202,7 @@ void thread_incr_recent_cpu(void);
 void calc_load_avg(void);
 void thread_all_calc_priority(void);
 void thread_all_calc_recent_cpu(void);
+void thread_foreach(thread_action_func *func, void *aux);
 
 // static cmp_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux);
 
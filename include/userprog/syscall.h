@@ -2,6 +2,8 @@
 #define USERPROG_SYSCALL_H
 
 void syscall_init(void);
+/* NOTE: [spawn] 로드에 실패한 자식이 종료 상태를 남기고 끝낼 때 process.c에서도 사용 */
+void exit(int status);
 typedef int pid_t;
 
 /* NOTE: [2.4] File에 대한 동시 접근을 막기 위한 filesys_lock 추가 */
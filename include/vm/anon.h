@@ -3,15 +3,37 @@
 #include "vm/vm.h"
 #include "lib/kernel/bitmap.h"
 struct page;
+struct shm_ref;
 enum vm_type;
 
+/* NOTE: [VM] 스왑 슬롯이 없음을 나타내는 슬롯 번호 */
+#define SWAP_NONE ((size_t)-1)
+/* NOTE: [VM] 모두 0인 페이지를 디스크 I/O 없이 내보냈음을 나타내는 슬롯 번호 */
+#define SWAP_ZERO ((size_t)-2)
+
 struct anon_page
 {
-    /* TODO: bitmap idx 저장?! */
+    /* NOTE: [VM] 페이지가 있는 스왑 슬롯 번호 (없으면 SWAP_NONE, 모두 0이라 스왑에 쓰지 않았으면 SWAP_ZERO) */
     size_t swap_table_idx;
+    /* NOTE: [VM] text 페이지의 로드 정보 - 스왑 대신 실행 파일에서 다시 읽음 */
+    struct page_load_info *text;
+    /* NOTE: [VM] 실행 파일에서 내용을 읽은 data 페이지의 로드 정보 - madvise(DONTNEED)로 버리면 다시 읽음 */
+    struct page_load_info *load;
+    /* NOTE: [VM] swap readahead로 미리 읽은 뒤 아직 쓰이지 않은 페이지 */
+    bool readahead;
+    /* NOTE: [VM] 공유 메모리 페이지면 세그먼트와 페이지 번호 - 스왑 슬롯은 세그먼트가 가짐 */
+    struct shm_ref *shm;
 };
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+void anon_swap_slot_dup(size_t swap_table_idx);
+size_t anon_swap_slots(void);
+bool anon_swap_save(const void *kva, size_t *slot);
+void anon_swap_load(size_t slot, void *kva);
+void anon_swap_drop(size_t slot);
+void anon_readahead_check(struct page *page, bool used);
+bool anon_discard(struct page *page);
+void anon_print_stats(void);
 
 #endif
@@ -1,9 +1,12 @@
 #ifndef VM_FILE_H
 #define VM_FILE_H
 #include "filesys/file.h"
+#include "lib/kernel/list.h"
+#include "threads/synch.h"
 #include "vm/vm.h"
 
 struct page;
+struct supplemental_page_table;
 enum vm_type;
 
 struct file_page
@@ -11,6 +14,32 @@ struct file_page
 	struct file *file;
 	off_t offset;
 	size_t read_bytes;
+	/* NOTE: [VM] readahead로 미리 읽은 뒤 아직 쓰이지 않은 페이지 */
+	bool readahead;
+};
+
+/* NOTE: [VM] 파일 매핑의 readahead 창의 최대 크기 (페이지) */
+#define FILE_RA_MAX 32
+
+/* NOTE: [VM] 파일 매핑 하나의 readahead 상태 - 프로세스의 spt마다 매핑별로 하나씩 둔다.
+ * 순차 접근이면 창(window)만큼의 다음 페이지를 readahead 스레드가 남는 frame에 읽어 두고,
+ * 스트림이 그 첫 페이지에 폴트를 내면 읽어 둔 frame을 한꺼번에 매핑한다. */
+struct file_ra
+{
+	struct file *file;	   /* 매핑의 파일 (mmap마다 file_reopen한 파일) */
+	void *last_va;		   /* 마지막으로 폴트가 난 주소 */
+	size_t window;		   /* 다음에 미리 읽을 페이지 수 */
+	struct list_elem elem; /* spt의 ra_list */
+
+	/* 미리 읽는 중이거나 읽어 둔 페이지 - buf_va부터 buf_cnt개 (0이면 없음) */
+	void *buf_va;
+	size_t buf_cnt;
+	void *buf_kva[FILE_RA_MAX];
+	off_t buf_ofs[FILE_RA_MAX];
+	size_t buf_bytes[FILE_RA_MAX];
+	struct semaphore done;	 /* readahead 스레드가 buf를 다 읽으면 up */
+	struct list_elem q_elem; /* readahead 스레드의 대기열 */
+	bool orphan;			 /* 읽는 중에 매핑이 사라짐 - readahead 스레드가 해제 */
 };
 
 void vm_file_init(void);
@@ -18,4 +47,13 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 			  struct file *file, off_t offset);
 void do_munmap(void *va);
+int do_msync(void *addr, size_t length, int flags);
+bool file_backed_discard(struct page *page);
+
+bool file_ra_map(struct page *page, bool unlock);
+bool file_readahead(struct page *page);
+void file_ra_check(struct page *page, bool used);
+void file_ra_forget(struct supplemental_page_table *spt, struct file *file);
+void file_ra_kill(struct supplemental_page_table *spt);
+void file_print_stats(void);
 #endif
@@ -0,0 +1,13 @@
+#ifndef VM_KSM_H
+#define VM_KSM_H
+#include <stdbool.h>
+
+struct frame;
+
+void ksm_enable(void);
+void ksm_init(void);
+void ksm_forget(struct frame *frame);
+void ksm_unmerge(struct frame *frame, bool last);
+void ksm_print_stats(void);
+
+#endif /* vm/ksm.h */
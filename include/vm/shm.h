@@ -0,0 +1,35 @@
+#ifndef VM_SHM_H
+#define VM_SHM_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+struct shm_segment;
+
+/* NOTE: [VM] 세그먼트 이름의 최대 길이 */
+#define SHM_NAME_MAX 14
+
+/* 공유 메모리 페이지가 가리키는 세그먼트의 페이지 - 페이지마다 하나씩 만들고 세그먼트의 참조를 하나 가짐 */
+struct shm_ref
+{
+	struct shm_segment *seg;
+	size_t idx; /* 세그먼트 안의 페이지 번호 */
+};
+
+void shm_init(void);
+void *do_shm_map(const char *name, size_t size, void *addr);
+int do_shm_unlink(const char *name);
+void shm_vma_get(struct shm_segment *seg);
+void shm_vma_put(struct shm_segment *seg);
+bool shm_alloc_page(struct shm_segment *seg, size_t idx, void *upage, bool writable);
+struct shm_ref *shm_page_ref(struct page *page);
+bool shm_resident(struct shm_ref *ref);
+bool shm_attach(struct page *page);
+bool shm_swap_in(struct page *page, void *kva);
+bool shm_swap_out(struct page *page);
+bool shm_discard(struct page *page);
+void shm_destroy(struct page *page);
+void shm_ref_free(struct shm_ref *ref);
+void shm_print_stats(void);
+
+#endif /* vm/shm.h */
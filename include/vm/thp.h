@@ -0,0 +1,13 @@
+#ifndef VM_THP_H
+#define VM_THP_H
+#include <stdbool.h>
+
+struct supplemental_page_table;
+
+void thp_enable(void);
+bool thp_fault(struct supplemental_page_table *spt, void *addr);
+bool thp_split_all(struct supplemental_page_table *spt);
+void thp_kill(struct supplemental_page_table *spt);
+void thp_print_stats(void);
+
+#endif /* vm/thp.h */
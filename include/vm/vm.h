@@ -24,6 +24,7 @@ enum vm_type
 	 * markers, until the value is fit in the int. */
 	VM_MARKER_0 = (1 << 3),
 	VM_MARKER_1 = (1 << 4),
+	VM_MARKER_2 = (1 << 5),
 
 	/* DO NOT EXCEED THIS VALUE. */
 	VM_MARKER_END = (1 << 31),
@@ -38,8 +39,13 @@ enum vm_type
 
 struct page_operations;
 struct thread;
+struct vma;
 
 #define VM_TYPE(type) ((type) & 7)
+/* NOTE: [VM] 읽기 전용 실행 파일 페이지 - 같은 실행 파일을 실행하는 프로세스끼리 frame 공유 */
+#define VM_TEXT VM_MARKER_1
+/* NOTE: [VM] 공유 메모리 세그먼트의 페이지 - 세그먼트를 매핑한 프로세스끼리 쓰기 가능한 frame 공유 */
+#define VM_SHM VM_MARKER_2
 
 /* The representation of "page".
  * This is kind of "parent class", which has four "child class"es, which are
@@ -56,7 +62,6 @@ struct page
 	/* NOTE: [VM] 추가적인 정보 추가 */
 	struct hash_elem hash_elem; /* SPT에 넣을 hash_elem */
 	bool writable;				/* 쓰기 가능 여부 */
-	int mapped_page_count;		/* 매핑된 총 페이지의 개수 */
 
 	/* NOTE: frame에 넣을 elem 추가 */
 	struct list_elem f_elem;
@@ -64,6 +69,12 @@ struct page
 	/* NOTE: page owner thread 추가 */
 	struct thread *owner;
 
+	/* NOTE: [VM] 2Q - cold 큐에서 쫓겨난 시점의 eviction 번호 (0이면 없음) */
+	unsigned evict_seq;
+
+	/* NOTE: [VM] madvise로 받은 접근 패턴 (MADV_NORMAL, MADV_RANDOM, MADV_SEQUENTIAL) */
+	uint8_t advice;
+
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
 	union
@@ -77,14 +88,47 @@ struct page
 	};
 };
 
+/* NOTE: [VM] frame 상태 플래그 */
+#define FRAME_USED 0x1 /* 페이지가 매핑되어 사용 중인 frame */
+#define FRAME_HOT 0x2  /* 2Q - hot 큐에 있는 frame (아니면 cold 큐) */
+#define FRAME_KSM 0x4  /* KSM - 같은 내용의 페이지들을 병합해 읽기 전용으로 공유하는 frame */
+
+/* NOTE: [VM] overcommit 정책 - 쓰기 가능한 anon 메모리를 예약할 때 전체 예약량을 제한하는 방법 */
+enum vm_overcommit
+{
+	VM_OVERCOMMIT_ALWAYS,	 /* 제한하지 않음 - 부족해지면 OOM killer가 처리 */
+	VM_OVERCOMMIT_HEURISTIC, /* 한 번의 예약이 메모리와 스왑을 합친 것보다 크면 거절 */
+	VM_OVERCOMMIT_NEVER,	 /* 전체 예약량이 스왑 + frame의 OVERCOMMIT_RATIO%를 넘지 않게 함 */
+};
+
+/* NOTE: [VM] 페이지 교체 정책 */
+enum vm_policy
+{
+	VM_POLICY_CLOCK, /* accessed 비트를 이용한 clock */
+	VM_POLICY_2Q,	 /* scan에 강한 2Q (cold FIFO + hot clock + ghost) */
+};
+
 /* The representation of "frame" */
 struct frame
 {
 	void *kva;
-	/* NOTE: frame 구조체 변경 - page_list & frame_table에 넣을 elem */
+	/* NOTE: frame 구조체 변경 - 이 frame을 매핑한 page들의 list (역매핑) */
 	// struct page *page;
 	struct list page_list;
-	struct list_elem ft_elem;
+	int pin_cnt;   /* NOTE: 0보다 크면 eviction 대상에서 제외 */
+	uint8_t flags; /* FRAME_USED 등 */
+	uint8_t age;   /* 마지막 접근 이후 clock이 지나간 횟수 */
+	struct list_elem q_elem; /* 2Q - cold/hot 큐에 넣을 elem */
+
+	/* NOTE: [VM] text cache에 올라간 frame이면 실행 파일의 inode와 offset */
+	struct inode *text_inode;
+	off_t text_ofs;
+	struct hash_elem text_elem;
+
+	/* NOTE: [VM] KSM - 마지막으로 계산한 내용의 checksum과 unstable table에 들어간 scan 회차 */
+	unsigned ksm_sum;
+	unsigned ksm_pass;
+	struct hash_elem ksm_elem;
 };
 
 /* The function table for page operations.
@@ -109,13 +153,30 @@ struct page_operations
 struct supplemental_page_table
 {
 	struct hash hash; /* hash 자료구조로 구현 */
+	struct list ra_list; /* NOTE: [VM] 파일 매핑의 readahead 상태 (struct file_ra) */
+	struct list vma_list;	/* NOTE: [VM] 실행 파일 segment와 mmap 구간 (struct vma, start 순) */
+	struct vma *vma_cache;	/* 마지막으로 찾은 구간 */
+	size_t thp_cnt;			/* NOTE: [VM] 2 MB 페이지로 매핑한 적이 있는 블록 수 - 0이면 THP 정리를 건너뜀 */
+
+	/* NOTE: [VM] 프로세스의 메모리 사용량 - meminfo 시스템 콜, OOM killer가 희생자를 고를 때 사용 */
+	size_t rss_anon_cnt;	/* frame에 올라와 있는 anon 페이지 수 (공유 frame은 공유하는 프로세스마다 셈) */
+	size_t rss_file_cnt;	/* frame에 올라와 있는 파일 매핑 페이지 수 */
+	size_t swap_cnt;		/* 스왑 슬롯에 있는 anon 페이지 수 */
+	size_t commit_cnt;		/* overcommit - 쓰기 가능한 anon 구간과 스택으로 예약한 페이지 수 */
+	size_t minor_fault_cnt; /* 디스크를 읽지 않고 처리한 폴트 수 */
+	size_t major_fault_cnt; /* 파일이나 스왑에서 읽어 처리한 폴트 수 */
 };
 
-/* NOTE: frame table 구조체 선언 */
+struct meminfo;
+
+/* NOTE: frame table 구조체 선언
+ * user pool의 모든 페이지에 대한 frame을 미리 배열로 할당하고 페이지 번호로 인덱싱한다. */
 struct frame_table
 {
-	struct list_elem *curr_frame;
-	struct list frame_list;
+	struct frame *frames; /* user pool 페이지 번호로 인덱싱되는 frame 배열 */
+	size_t frame_cnt;	  /* user pool의 페이지 수 */
+	uint8_t *base;		  /* user pool의 첫 페이지 */
+	size_t hand;		  /* clock hand - 다음에 검사할 frame 번호 */
 };
 
 #include "threads/thread.h"
@@ -129,6 +190,18 @@ bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
 
 void vm_init(void);
+void vm_set_policy(const char *name);
+void vm_enable_kswapd(void);
+void vm_set_fault_around(int pages);
+void vm_set_overcommit(const char *name);
+bool vm_commit(struct supplemental_page_table *spt, size_t pages);
+void vm_uncommit(struct supplemental_page_table *spt, size_t pages);
+void vm_swap_account(struct supplemental_page_table *spt, int delta);
+bool vm_meminfo(int pid, struct meminfo *info);
+void vm_exec_loaded(void);
+extern struct lock vm_lock;
+bool vm_lock_acquire(void);
+void vm_lock_release(bool locked);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 						 bool write, bool not_present);
 
@@ -138,7 +211,23 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
 									bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page(struct page *page);
 bool vm_claim_page(void *va);
+int vm_madvise(void *addr, size_t length, int advice);
+bool vm_claim_page_nowait(struct page *page);
+void *vm_frame_alloc_nowait(void);
+void vm_frame_free_unused(void *kva);
+void *vm_frame_alloc_huge(void);
+void vm_frame_attach(struct page *page, void *kva);
+void vm_page_set_frame(struct page *page, struct frame *frame);
+bool vm_frame_adopt(struct page *page, void *kva);
+void vm_frame_unlink(struct page *page);
+void vm_frame_unpin(struct frame *frame);
+struct frame *vm_frame_lookup(void *kva);
+struct frame *vm_frame_at(size_t idx);
+size_t vm_frame_cnt(void);
+bool vm_frame_move(struct page *page, struct frame *frame);
+void vm_dump_frames(void);
 enum vm_type page_get_type(struct page *page);
+void vm_print_stats(void);
 
 struct page_load_info
 {
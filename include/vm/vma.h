@@ -0,0 +1,42 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "lib/kernel/list.h"
+#include "vm/vm.h"
+
+struct file;
+struct shm_segment;
+
+/* NOTE: [VM] VMA - 같은 방법으로 채우는 연속된 페이지 구간 (실행 파일의 segment 하나, mmap 하나)
+ * 구간의 페이지 구조체는 그 페이지에 처음 폴트가 날 때 만든다.
+ * 구간 안의 페이지 i는 파일의 offset + min(read_bytes, i * PGSIZE)부터 읽고 나머지는 0으로 채운다. */
+struct vma
+{
+	uint8_t *start;		   /* 첫 페이지 주소 */
+	uint8_t *end;		   /* 마지막 페이지 다음 주소 */
+	enum vm_type type;	   /* 만들 페이지의 타입 (VM_ANON, VM_ANON | VM_TEXT, VM_ANON | VM_SHM, VM_FILE) */
+	bool writable;		   /* 쓰기 가능 여부 */
+	struct file *file;	   /* 내용을 읽을 파일 */
+	off_t offset;		   /* start에 해당하는 파일 offset */
+	size_t read_bytes;	   /* start부터 파일에서 읽을 바이트 수 */
+	uint8_t advice;		   /* madvise로 받은 접근 패턴 - 새로 만드는 페이지에 적용 */
+	struct shm_segment *shm; /* 공유 메모리 구간이면 세그먼트 - offset / PGSIZE가 start의 페이지 번호 */
+	struct list_elem elem; /* spt의 vma_list (start 순) */
+};
+
+bool vma_map(struct supplemental_page_table *spt, void *start, size_t length, enum vm_type type,
+			 bool writable, struct file *file, off_t offset, size_t read_bytes);
+bool vma_map_shm(struct supplemental_page_table *spt, void *start, size_t length, struct shm_segment *seg);
+struct vma *vma_find(struct supplemental_page_table *spt, void *va);
+bool vma_overlaps(struct supplemental_page_table *spt, void *start, void *end);
+struct page *vma_get_page(struct supplemental_page_table *spt, void *va);
+void vma_populate(struct supplemental_page_table *spt, void *start, void *end);
+void vma_set_advice(struct supplemental_page_table *spt, void *start, void *end, int advice);
+void vma_unmap(struct supplemental_page_table *spt, void *start);
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src);
+void vma_kill(struct supplemental_page_table *spt);
+
+#endif /* vm/vma.h */
@@ -0,0 +1,18 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/* NOTE: [VM] 스왑 디스크에 슬롯 하나를 쓰는 함수 - 캐시가 가득 차면 오래된 페이지를 내보낼 때 사용 */
+typedef void zswap_writeback_func(size_t slot, const void *page);
+
+void zswap_init(size_t max_pages, zswap_writeback_func *writeback);
+bool zswap_store(size_t slot, const void *page);
+bool zswap_load(size_t slot, void *page);
+void zswap_invalidate(size_t slot);
+void zswap_print_stats(void);
+
+size_t lz_compress(const void *src, size_t src_len, void *dst, size_t dst_cap);
+size_t lz_decompress(const void *src, size_t src_len, void *dst, size_t dst_cap);
+
+#endif /* vm/zswap.h */
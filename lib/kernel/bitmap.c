@@ -27,6 +27,7 @@ typedef unsigned long elem_type;
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	size_t first_free;  /* No bit below this index is false. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -63,6 +64,77 @@ last_mask (const struct bitmap *b) {
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns element ELEM_IDX of B with a 1 wherever a bit in it is
+   VALUE.  Bits past the end of B are reported as !VALUE. */
+static inline elem_type
+elem_match (const struct bitmap *b, size_t elem_idx, bool value) {
+	elem_type bits = value ? b->bits[elem_idx] : ~b->bits[elem_idx];
+	if (elem_idx == elem_cnt (b->bit_cnt) - 1)
+		bits &= last_mask (b);
+	return bits;
+}
+
+/* Returns a mask of bits FROM through TO - 1 of an element,
+   where 0 <= FROM < TO <= ELEM_BITS. */
+static inline elem_type
+range_mask (size_t from, size_t to) {
+	elem_type high = to < ELEM_BITS ? ((elem_type) 1 << to) - 1 : (elem_type) -1;
+	return high & ~(((elem_type) 1 << from) - 1);
+}
+
+/* Returns the number of 1 bits in BITS.  (The kernel is not linked
+   with libgcc, which __builtin_popcountl() may call, and POPCNT is
+   not on every CPU Pintos runs on.) */
+static inline size_t
+elem_popcount (elem_type bits) {
+	bits = bits - ((bits >> 1) & 0x5555555555555555UL);
+	bits = (bits & 0x3333333333333333UL) + ((bits >> 2) & 0x3333333333333333UL);
+	bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+	return (bits * 0x0101010101010101UL) >> 56;
+}
+
+/* Atomically sets the bits in MASK of element ELEM_IDX in B to
+   VALUE. */
+static inline void
+elem_set (struct bitmap *b, size_t elem_idx, elem_type mask, bool value) {
+	if (value)
+		asm ("lock orq %1, %0" : "+m" (b->bits[elem_idx]) : "r" (mask) : "cc");
+	else
+		asm ("lock andq %1, %0" : "+m" (b->bits[elem_idx]) : "r" (~mask) : "cc");
+}
+
+/* Returns the index of the first bit at or after START in B that
+   is VALUE, or the size of B if there is none.  Looks at a whole
+   element at a time. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) {
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	size_t idx = elem_idx (start);
+	size_t last = elem_cnt (b->bit_cnt) - 1;
+	elem_type bits = elem_match (b, idx, value)
+		& ~(bit_mask (start) - 1);
+	while (bits == 0) {
+		if (idx == last)
+			return b->bit_cnt;
+		bits = elem_match (b, ++idx, value);
+	}
+	return idx * ELEM_BITS + __builtin_ctzl (bits);
+}
+
+/* Lowers B's first_free hint to IDX, which has just become false.
+   Uses compare-and-swap so that a concurrent scan cannot raise
+   the hint past IDX afterward. */
+static void
+hint_lower (struct bitmap *b, size_t idx) {
+	size_t hint = __atomic_load_n (&b->first_free, __ATOMIC_RELAXED);
+	while (idx < hint
+			&& !__atomic_compare_exchange_n (&b->first_free, &hint, idx, false,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		continue;
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -74,6 +146,7 @@ bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
+		b->first_free = 0;
 		b->bits = malloc (byte_cnt (bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
 			bitmap_set_all (b, false);
@@ -94,6 +167,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 	ASSERT (block_size >= bitmap_buf_size (bit_cnt));
 
 	b->bit_cnt = bit_cnt;
+	b->first_free = 0;
 	b->bits = (elem_type *) (b + 1);
 	bitmap_set_all (b, false);
 	return b;
@@ -160,6 +234,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the AND instruction in [IA32-v2a]. */
 	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	hint_lower (b, bit_idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -174,6 +249,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
 	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	hint_lower (b, bit_idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -194,33 +270,43 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	size_t end = start + cnt;
+	for (size_t i = start; i < end; ) {
+		size_t ofs = i % ELEM_BITS;
+		size_t n = end - i < ELEM_BITS - ofs ? end - i : ELEM_BITS - ofs;
+		elem_set (b, elem_idx (i), range_mask (ofs, ofs + n), value);
+		i += n;
+	}
+	if (!value && cnt > 0)
+		hint_lower (b, start);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i, value_cnt;
+	size_t value_cnt = 0;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
+	size_t end = start + cnt;
+	for (size_t i = start; i < end; ) {
+		size_t ofs = i % ELEM_BITS;
+		size_t n = end - i < ELEM_BITS - ofs ? end - i : ELEM_BITS - ofs;
+		value_cnt += elem_popcount (elem_match (b, elem_idx (i), value)
+				& range_mask (ofs, ofs + n));
+		i += n;
+	}
 	return value_cnt;
 }
 
@@ -228,16 +314,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			return true;
-	return false;
+	return cnt > 0 && find_next (b, start, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -266,7 +347,10 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+   Jumps from one run of VALUE bits to the next a whole element at
+   a time, and, when looking for false bits, starts no lower than
+   the first bit that may be false. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
@@ -274,10 +358,24 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 
 	if (cnt <= b->bit_cnt) {
 		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
+		size_t i = start;
+
+		if (cnt == 0)
+			return start <= last ? start : BITMAP_ERROR;
+		if (!value && i < b->first_free)
+			i = b->first_free;
+		while (i <= last) {
+			i = find_next (b, i, value);
+			if (i > last)
+				break;
+			if (cnt == 1)
 				return i;
+
+			size_t end = find_next (b, i + 1, !value);
+			if (end - i >= cnt)
+				return i;
+			i = end;
+		}
 	}
 	return BITMAP_ERROR;
 }
@@ -291,12 +389,22 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    setting them. */
 size_t
 bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value) {
+	size_t hint = b->first_free;
 	size_t idx = bitmap_scan (b, start, cnt, value);
-	if (idx != BITMAP_ERROR)
+	if (idx != BITMAP_ERROR) {
 		bitmap_set_multiple (b, idx, cnt, !value);
+
+		/* Every bit below IDX is true if the scan began at the
+		   hint and took the very first false bit.  Raising the
+		   hint fails harmlessly if a bit was freed meanwhile. */
+		if (!value && cnt > 0 && start <= hint
+				&& (idx == hint || (cnt == 1 && idx >= hint)))
+			__atomic_compare_exchange_n (&b->first_free, &hint, idx + cnt,
+					false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
 	return idx;
 }
-
+
 /* File input and output. */
 
 #ifdef FILESYS
@@ -315,6 +423,7 @@ bitmap_read (struct bitmap *b, struct file *file) {
 		off_t size = byte_cnt (b->bit_cnt);
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		b->first_free = 0;
 	}
 	return success;
 }
@@ -90,6 +90,11 @@ exec (const char *file) {
 	return (pid_t) syscall1 (SYS_EXEC, file);
 }
 
+pid_t
+spawn (const char *cmd_line) {
+	return (pid_t) syscall1 (SYS_SPAWN, cmd_line);
+}
+
 int
 wait (pid_t pid) {
 	return syscall1 (SYS_WAIT, pid);
@@ -155,6 +160,31 @@ munmap (void *addr) {
 	syscall1 (SYS_MUNMAP, addr);
 }
 
+int
+madvise (void *addr, size_t length, int advice) {
+	return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+msync (void *addr, size_t length, int flags) {
+	return syscall3 (SYS_MSYNC, addr, length, flags);
+}
+
+int
+meminfo (pid_t pid, struct meminfo *info) {
+	return syscall2 (SYS_MEMINFO, pid, info);
+}
+
+void *
+shm_map (const char *name, size_t size, void *addr) {
+	return (void *) syscall3 (SYS_SHM_MAP, name, size, addr);
+}
+
+int
+shm_unlink (const char *name) {
+	return syscall1 (SYS_SHM_UNLINK, name);
+}
+
 bool
 chdir (const char *dir) {
 	return syscall1 (SYS_CHDIR, dir);
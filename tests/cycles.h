@@ -0,0 +1,15 @@
+#ifndef TESTS_CYCLES_H
+#define TESTS_CYCLES_H
+
+/* Returns the time stamp counter, for tests that report how many
+   cycles an operation took. */
+static inline unsigned long long
+rdtsc (void)
+{
+  unsigned lo, hi;
+
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((unsigned long long) hi << 32) | lo;
+}
+
+#endif /* tests/cycles.h */
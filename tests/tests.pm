@@ -33,6 +33,26 @@ sub check_expected {
     compare_output ("run", @options, \@output, $expected);
 }
 
+# Like check_expected, but compares line by line and each expected
+# line may be a qr// pattern, for tests that print measurements that
+# differ from run to run.  Process exit lines are ignored.
+sub check_expected_lines {
+    my (@expected) = @_;
+    my (@output) = read_text_file ("$test.output");
+
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+    @output = grep (!/^[a-zA-Z0-9-_]+: exit\(\-?\d+\)$/, @output);
+
+    fail "Expected " . scalar (@expected) . " lines of output but got "
+      . scalar (@output) . "\n" if @output != @expected;
+    for my $i (0...$#expected) {
+	my ($want) = $expected[$i];
+	fail "Line $i: expected \"$want\" but got \"$output[$i]\"\n"
+	  if ref ($want) ? $output[$i] !~ $want : $output[$i] ne $want;
+    }
+}
+
 sub common_checks {
     my ($run, @output) = @_;
 
@@ -0,0 +1,102 @@
+/* Checks and times bitmap_scan() from lib/kernel/bitmap.c.
+
+   Fills a 1 M-bit map to various ratios at random, checks
+   bitmap_scan() against a bit-by-bit scan, and measures how long
+   it takes to find free runs of a few lengths.  The tick counts
+   differ from run to run; only the scan results are checked. */
+
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+
+/* Number of bits in the map. */
+#define BIT_CNT (1024 * 1024)
+
+/* Number of scans timed per fill ratio and run length. */
+#define SCAN_CNT 200
+
+static void fill (struct bitmap *, int percent);
+static size_t slow_scan (const struct bitmap *, size_t start, size_t cnt);
+static void check_scan (const struct bitmap *, size_t start, size_t cnt);
+
+void
+test_bitmap_scan (void)
+{
+  static const int percents[] = { 0, 50, 90, 99 };
+  static const size_t cnts[] = { 1, 8, 64 };
+  struct bitmap *b = bitmap_create (BIT_CNT);
+  size_t i, j;
+
+  if (b == NULL)
+    fail ("couldn't create %d-bit map", BIT_CNT);
+  random_init (0);
+  for (i = 0; i < sizeof percents / sizeof *percents; i++)
+    {
+      fill (b, percents[i]);
+      msg ("%d%% full, %zu bits free", percents[i],
+           bitmap_count (b, 0, BIT_CNT, false));
+      for (j = 0; j < sizeof cnts / sizeof *cnts; j++)
+        {
+          size_t cnt = cnts[j];
+          int64_t start;
+          int k;
+
+          check_scan (b, 0, cnt);
+          for (k = 0; k < 8; k++)
+            check_scan (b, random_ulong () % BIT_CNT, cnt);
+
+          start = timer_ticks ();
+          for (k = 0; k < SCAN_CNT; k++)
+            bitmap_scan (b, random_ulong () % BIT_CNT, cnt, false);
+          msg ("%d%% full, run %zu: %lld ticks",
+               percents[i], cnt, timer_elapsed (start));
+        }
+    }
+  bitmap_destroy (b);
+}
+
+/* Sets about PERCENT percent of B's bits to true at random. */
+static void
+fill (struct bitmap *b, int percent)
+{
+  size_t i;
+
+  bitmap_set_all (b, false);
+  for (i = 0; i < BIT_CNT; i++)
+    if ((int) (random_ulong () % 100) < percent)
+      bitmap_mark (b, i);
+}
+
+/* Finds the first run of CNT false bits in B at or after START
+   one bit at a time, the way bitmap_scan() used to. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt)
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= BIT_CNT; i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j))
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Fails unless bitmap_scan() finds the same run of CNT false
+   bits in B at or after START as slow_scan(). */
+static void
+check_scan (const struct bitmap *b, size_t start, size_t cnt)
+{
+  size_t fast = bitmap_scan (b, start, cnt, false);
+  size_t slow = slow_scan (b, start, cnt);
+
+  if (fast != slow)
+    fail ("bitmap_scan (%zu, %zu) returned %zu, expected %zu",
+          start, cnt, fast, slow);
+}
@@ -0,0 +1,29 @@
+# -*- perl -*-
+
+# The expected output looks like this:
+#
+# (bitmap-scan) begin
+# (bitmap-scan) 0% full, 1048576 bits free
+# (bitmap-scan) 0% full, run 1: 0 ticks
+# (bitmap-scan) 0% full, run 8: 0 ticks
+# (bitmap-scan) 0% full, run 64: 0 ticks
+# (bitmap-scan) 50% full, 524012 bits free
+# ...
+# (bitmap-scan) end
+#
+# The free bit counts depend on the random fill and the tick counts
+# differ from run to run.
+
+use strict;
+use warnings;
+use tests::tests;
+
+my (@expected) = ('(bitmap-scan) begin');
+for my $percent (0, 50, 90, 99) {
+    push (@expected, qr/^\(bitmap-scan\) $percent% full, \d+ bits free$/);
+    push (@expected, qr/^\(bitmap-scan\) $percent% full, run $_: \d+ ticks$/)
+      foreach 1, 8, 64;
+}
+push (@expected, '(bitmap-scan) end');
+check_expected_lines (@expected);
+pass;
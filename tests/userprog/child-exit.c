@@ -0,0 +1,13 @@
+/* Child process run by spawn-loop.
+   Exits at once with the status given as its argument. */
+
+#include <stdlib.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-exit";
+
+int
+main (int argc, char *argv[])
+{
+  return argc > 1 ? atoi (argv[1]) : -1;
+}
@@ -0,0 +1,40 @@
+/* Forks a child, then parent and child both sweep a small working
+   set of pages over and over while the timer switches between
+   them.  Every switch changes address spaces, so the run time
+   reflects how much of the TLB survives a switch; compare the timer
+   ticks and the "Paging:" CR3 statistics reported at power off. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+#define ROUNDS 20000
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+static void
+sweep (void)
+{
+  int round, i;
+
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < PAGE_CNT; i++)
+      buf[i * PAGE_SIZE + round % PAGE_SIZE]++;
+}
+
+void
+test_main (void)
+{
+  int pid;
+
+  msg ("fork");
+  if ((pid = fork ("child"))) {
+    sweep ();
+    msg ("Parent: child exit status is %d", wait (pid));
+  } else {
+    sweep ();
+    exit (81);
+  }
+}
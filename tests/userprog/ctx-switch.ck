@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ctx-switch) begin
+(ctx-switch) fork
+child: exit(81)
+(ctx-switch) Parent: child exit status is 81
+(ctx-switch) end
+ctx-switch: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+/* Forks and waits for a child that exits at once, many times over,
+   so that the run time is dominated by creating and tearing down
+   address spaces.  The "Page tables:" statistics reported at power
+   off show how many page tables were recycled. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 64
+
+void
+test_main (void)
+{
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      int pid = fork ("child");
+      if (pid == 0)
+        exit (i);
+      if (wait (pid) != i)
+        fail ("child %d returned wrong exit status", i);
+    }
+}
@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my ($expected) = "(fork-loop) begin\n";
+$expected .= "child: exit($_)\n" foreach 0..63;
+$expected .= "(fork-loop) end\nfork-loop: exit(0)\n";
+check_expected ([$expected]);
+pass;
@@ -0,0 +1,63 @@
+/* Starts a short-lived program many times from a parent with a
+   512 kB working set, first with fork, exec, and wait, then with
+   spawn and wait, and reports the cycles spent per child for
+   each.  fork copies the parent's address space and file
+   descriptors only for exec to throw them away; spawn loads the
+   program into a fresh address space directly.  Also checks that
+   spawn passes arguments and fails for a missing program. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/cycles.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define WORK_PAGES 128
+#define CHILD_CNT 32
+
+static char work[WORK_PAGES * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  unsigned long long start;
+  char cmd_line[32];
+  pid_t pid;
+  int i;
+
+  for (i = 0; i < WORK_PAGES; i++)
+    work[i * PAGE_SIZE] = i;
+
+  start = rdtsc ();
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      snprintf (cmd_line, sizeof cmd_line, "child-exit %d", i);
+      pid = fork ("child");
+      if (pid == 0)
+        {
+          exec (cmd_line);
+          exit (-1);
+        }
+      if (wait (pid) != i)
+        fail ("forked child %d returned wrong exit status", i);
+    }
+  msg ("fork-exec-wait: %llu cycles per child", (rdtsc () - start) / CHILD_CNT);
+
+  start = rdtsc ();
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      snprintf (cmd_line, sizeof cmd_line, "child-exit %d", i);
+      pid = spawn (cmd_line);
+      if (pid == PID_ERROR)
+        fail ("spawn \"%s\" failed", cmd_line);
+      if (wait (pid) != i)
+        fail ("spawned child %d returned wrong exit status", i);
+    }
+  msg ("spawn-wait: %llu cycles per child", (rdtsc () - start) / CHILD_CNT);
+
+  CHECK (spawn ("no-such-file") == PID_ERROR, "spawn \"no-such-file\" fails");
+  for (i = 0; i < WORK_PAGES; i++)
+    if (work[i * PAGE_SIZE] != (char) i)
+      fail ("working set page %d corrupted", i);
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+
+# The expected output looks like this, after dropping the exit
+# lines of the children:
+#
+# (spawn-loop) begin
+# (spawn-loop) fork-exec-wait: 2718260 cycles per child
+# (spawn-loop) spawn-wait: 905334 cycles per child
+# (spawn-loop) spawn "no-such-file" fails
+# (spawn-loop) end
+#
+# The cycle counts differ from run to run.
+
+use strict;
+use warnings;
+use tests::tests;
+
+check_expected_lines (
+    '(spawn-loop) begin',
+    qr/^\(spawn-loop\) fork-exec-wait: \d+ cycles per child$/,
+    qr/^\(spawn-loop\) spawn-wait: \d+ cycles per child$/,
+    '(spawn-loop) spawn "no-such-file" fails',
+    '(spawn-loop) end');
+pass;
@@ -0,0 +1,33 @@
+/* Runs a program with a 512 MB bss segment and touches only a
+   few of its pages.  The kernel should track the segment as a
+   single region and create page state only for the pages that
+   are actually touched. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (512 * 1024 * 1024)
+#define STRIDE (8 * 1024 * 1024)
+
+static char sparse[SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  msg ("write pass");
+  for (i = 0; i < SIZE; i += STRIDE)
+    sparse[i] = i / STRIDE + 1;
+
+  msg ("read pass");
+  for (i = 0; i < SIZE; i += STRIDE)
+    if (sparse[i] != (char) (i / STRIDE + 1))
+      fail ("byte %zu is %d, expected %d", i, sparse[i], (int) (i / STRIDE + 1));
+
+  msg ("untouched pages are zero");
+  for (i = STRIDE / 2; i < SIZE; i += STRIDE)
+    if (sparse[i] != 0)
+      fail ("byte %zu is %d, expected 0", i, sparse[i]);
+}
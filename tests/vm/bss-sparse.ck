@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bss-sparse) begin
+(bss-sparse) write pass
+(bss-sparse) read pass
+(bss-sparse) untouched pages are zero
+(bss-sparse) end
+EOF
+pass;
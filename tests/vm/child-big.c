@@ -0,0 +1,25 @@
+/* Child process of exec-faults.
+   Reads a 64 kB read-only table and a 64 kB initialized data
+   array, both of which are loaded lazily from the executable,
+   and exits with a fixed status. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-big";
+
+#define TABLE_SIZE 65536
+
+static const uint8_t table[TABLE_SIZE] = { [0 ... TABLE_SIZE - 1] = 3 };
+static uint8_t data[TABLE_SIZE] = { [0 ... TABLE_SIZE - 1] = 5 };
+
+int
+main (void)
+{
+  unsigned sum = 0;
+  size_t i;
+
+  for (i = 0; i < TABLE_SIZE; i++)
+    sum += table[i] + data[i];
+  return sum == 8u * TABLE_SIZE ? 0x42 : 0;
+}
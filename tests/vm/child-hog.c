@@ -0,0 +1,25 @@
+/* Child process of oom-kill.
+   Keeps writing to a bss array much larger than RAM and swap
+   together, so that it can only be stopped by the OOM killer. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-hog";
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT (32 * 256)
+
+static uint8_t hog[PAGE_CNT * PAGE_SIZE];
+
+int
+main (void)
+{
+  size_t i;
+  int round;
+
+  for (round = 1; round <= 4; round++)
+    for (i = 0; i < PAGE_CNT; i++)
+      hog[i * PAGE_SIZE] = round;
+  return 0;
+}
@@ -0,0 +1,26 @@
+/* Child process of shm-share.
+   Maps the "seg" shared memory segment by name at a different
+   address than its parent, checks the pattern the parent wrote,
+   and leaves a mark for the parent to find. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-shm";
+
+#define SEG_SIZE (4 * 4096)
+#define SHARED ((char *) 0x20000000)
+
+int
+main (void)
+{
+  size_t i;
+
+  if (shm_map ("seg", SEG_SIZE, SHARED) != SHARED)
+    return 1;
+  for (i = 2; i < SEG_SIZE; i++)
+    if (SHARED[i] != (char) (i % 251))
+      return 2;
+  SHARED[1] = 's';
+  return 0;
+}
@@ -0,0 +1,21 @@
+/* Child process of text-share.
+   Checksums its own code pages, which are mapped read-only, and
+   exits with a fixed status.  Many copies run at once so that
+   the text pages are shared between them. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-text";
+
+int
+main (void)
+{
+  const uint8_t *p = (const uint8_t *) main;
+  unsigned sum = 0;
+  size_t i;
+
+  for (i = 0; i < 256; i++)
+    sum += p[i];
+  return sum != 0 ? 0x42 : 0;
+}
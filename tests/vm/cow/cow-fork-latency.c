@@ -0,0 +1,52 @@
+/* Dirties a 1 MB heap and then forks many children that each
+   read all of it and write one page before exiting.  With
+   copy-on-write only the written page is copied, so the run time
+   is dominated by fork itself; the "COW:" statistics reported at
+   power off show how many pages were shared and copied. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+#define CHILD_CNT 16
+
+static char heap[PAGE_CNT * PAGE_SIZE];
+
+static void
+child (int id)
+{
+	size_t i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		if (heap[i * PAGE_SIZE] != (char) i)
+			exit (-1);
+	heap[id * PAGE_SIZE] = '@';
+	exit (id);
+}
+
+void
+test_main (void)
+{
+	size_t i;
+	int id;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		memset (heap + i * PAGE_SIZE, (char) i, PAGE_SIZE);
+	msg ("dirtied %d pages", PAGE_CNT);
+
+	for (id = 0; id < CHILD_CNT; id++) {
+		pid_t pid = fork ("child");
+		if (pid == 0)
+			child (id);
+		if (wait (pid) != id)
+			fail ("child %d returned wrong exit status", id);
+	}
+
+	for (i = 0; i < PAGE_CNT; i++)
+		if (heap[i * PAGE_SIZE] != (char) i)
+			fail ("parent page %zu changed after fork", i);
+	msg ("parent data intact");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my ($expected) = "(cow-fork-latency) begin\n";
+$expected .= "(cow-fork-latency) dirtied 256 pages\n";
+$expected .= "child: exit($_)\n" foreach 0..15;
+$expected .= "(cow-fork-latency) parent data intact\n";
+$expected .= "(cow-fork-latency) end\ncow-fork-latency: exit(0)\n";
+check_expected ([$expected]);
+pass;
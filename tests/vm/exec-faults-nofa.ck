@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'XEOF']);
+(exec-faults-nofa) begin
+(exec-faults-nofa) ran child-big 8 times
+(exec-faults-nofa) end
+XEOF
+pass;
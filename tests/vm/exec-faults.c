@@ -0,0 +1,28 @@
+/* Execs a program with large read-only and data segments several
+   times, one after another.  Every page of both segments is read
+   from the executable; with fault-around most of them are mapped
+   by the fault on a neighbouring page.  The "Fault-around:" line
+   reported at power off shows the page faults taken per exec. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 8
+
+void
+test_main (void)
+{
+  int i;
+
+  for (i = 0; i < EXEC_CNT; i++) {
+    pid_t child = fork ("child-big");
+    if (child == 0) {
+      if (exec ("child-big") == -1)
+        fail ("failed to exec child-big");
+    }
+    if (wait (child) != 0x42)
+      fail ("child %d returned wrong exit status", i);
+  }
+  msg ("ran child-big %d times", EXEC_CNT);
+}
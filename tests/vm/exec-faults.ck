@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'XEOF']);
+(exec-faults) begin
+(exec-faults) ran child-big 8 times
+(exec-faults) end
+XEOF
+pass;
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fault-latency-kswapd) begin
+(fault-latency-kswapd) wrote 1536 pages
+(fault-latency-kswapd) read back 1536 pages
+(fault-latency-kswapd) read back 1536 pages
+(fault-latency-kswapd) read back 1536 pages
+(fault-latency-kswapd) end
+EOF
+pass;
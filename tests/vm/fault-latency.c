@@ -0,0 +1,28 @@
+/* Streams through a buffer larger than memory, comparing each page
+   against its expected contents after touching it, so that page
+   faults keep needing frames while there is computation for a
+   background reclaimer to overlap with.  Run as fault-latency
+   (faults evict directly) and fault-latency-kswapd (kernel option
+   -kswapd); the "Fault latency:" and "Reclaim:" lines reported at
+   power off compare the fault latency percentiles and who did the
+   evicting. */
+
+#include <string.h>
+#include "tests/vm/swap-buf.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PASSES 3
+
+/* Fills page I with the byte I. */
+static void
+fill_page (size_t i, char *page)
+{
+  memset (page, i, PAGE_SIZE);
+}
+
+void
+test_main (void)
+{
+  swap_buf_run (fill_page, PASSES);
+}
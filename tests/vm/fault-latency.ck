@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fault-latency) begin
+(fault-latency) wrote 1536 pages
+(fault-latency) read back 1536 pages
+(fault-latency) read back 1536 pages
+(fault-latency) read back 1536 pages
+(fault-latency) end
+EOF
+pass;
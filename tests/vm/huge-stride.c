@@ -0,0 +1,42 @@
+/* Touches 64 MB of memory one page at a time, several times over,
+   then verifies it.  Each pass walks more pages than the TLB can
+   hold, so its run time is dominated by page walks; compare the
+   timer ticks reported at power off with and without 2 MB pages. */
+
+#include <string.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SIZE (64 * 1024 * 1024)
+#define PASSES 8
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+  int pass;
+
+  msg ("write pass");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    buf[i] = (char) (i / PAGE_SIZE);
+
+  msg ("stride passes");
+  for (pass = 0; pass < PASSES; pass++)
+    for (i = 0; i < SIZE; i += PAGE_SIZE)
+      buf[i + (pass * 64) % PAGE_SIZE] += 1;
+
+  msg ("read pass");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    {
+      int pass_ofs;
+      if (buf[i] != (char) (i / PAGE_SIZE + 1))
+        fail ("byte %zu is %d", i, buf[i]);
+      for (pass_ofs = 1; pass_ofs < PASSES; pass_ofs++)
+        if (buf[i + pass_ofs * 64] != 1)
+          fail ("byte %zu is %d", i + pass_ofs * 64, buf[i + pass_ofs * 64]);
+    }
+}
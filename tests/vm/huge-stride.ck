@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(huge-stride) begin
+(huge-stride) write pass
+(huge-stride) stride passes
+(huge-stride) read pass
+(huge-stride) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Fills 256 pages with the same table, keeps reading them while
+   the same-page merging daemon (kernel option -ksm) scans memory,
+   then writes to every other page and checks that every page still
+   holds what was written.  The "KSM:" line reported at power off
+   shows how many pages were merged and how many were split again
+   by the writes. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+#define ROUNDS 100
+
+static char buf[PAGE_CNT][PAGE_SIZE];
+static char table[PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+  int round;
+
+  for (i = 0; i < PAGE_SIZE; i++)
+    table[i] = i * 7 + i / 256;
+  for (i = 0; i < PAGE_CNT; i++)
+    memcpy (buf[i], table, PAGE_SIZE);
+  msg ("filled %d identical pages", PAGE_CNT);
+
+  /* Give the daemon time to find the pages stable and merge them. */
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < PAGE_CNT; i++)
+      if (memcmp (buf[i], table, PAGE_SIZE))
+        fail ("page %zu changed in round %d", i, round);
+  msg ("read %d pages %d times", PAGE_CNT, ROUNDS);
+
+  for (i = 0; i < PAGE_CNT; i += 2)
+    buf[i][i] = ~table[i];
+  msg ("wrote %d pages", PAGE_CNT / 2);
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      if (buf[i][i] != (i % 2 == 0 ? (char) ~table[i] : table[i]))
+        fail ("page %zu has the wrong contents", i);
+      buf[i][i] = table[i];
+      if (memcmp (buf[i], table, PAGE_SIZE))
+        fail ("page %zu has the wrong contents", i);
+    }
+  msg ("verified %d pages", PAGE_CNT);
+}
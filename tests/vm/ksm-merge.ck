@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(ksm-merge) begin
+(ksm-merge) filled 256 identical pages
+(ksm-merge) read 256 pages 100 times
+(ksm-merge) wrote 128 pages
+(ksm-merge) verified 256 pages
+(ksm-merge) end
+EOF
+pass;
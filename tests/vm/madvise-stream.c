@@ -0,0 +1,76 @@
+/* Streams through a mapped 2 MB file twice while repeatedly
+   looking up a 1.5 MB in-memory index, in less memory than both
+   need together.  The first pass gives no hint; the second marks
+   the mapping MADV_SEQUENTIAL, so pages behind the stream are
+   dropped instead of pushing the index out.  Reports the cycles
+   spent per file page for each pass; the "Advice:" line reported
+   at power off shows how many pages were dropped behind. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/cycles.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define INDEX_PAGES 384
+#define CHUNK_PAGES 16
+#define ACTUAL ((char *) 0x10000000)
+
+static char index[INDEX_PAGES * PAGE_SIZE];
+static unsigned expected;
+
+/* Reads the mapped file a chunk at a time, looking up every index
+   page after each chunk, and reports the cycles spent per page. */
+static void
+stream (const char *name, size_t size)
+{
+  unsigned long long start = rdtsc ();
+  size_t page_cnt = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+  unsigned sum = 0;
+  size_t i, j;
+
+  for (i = 0; i < page_cnt; i += CHUNK_PAGES)
+    {
+      size_t end = (i + CHUNK_PAGES) * PAGE_SIZE;
+      if (end > size)
+        end = size;
+      for (j = i * PAGE_SIZE; j < end; j++)
+        sum = sum * 31 + (unsigned char) ACTUAL[j];
+      for (j = 0; j < INDEX_PAGES; j++)
+        if (index[j * PAGE_SIZE] != (char) j)
+          fail ("%s: index page %zu is wrong", name, j);
+    }
+  if (sum != expected)
+    fail ("%s: checksum of the mapping is wrong", name);
+  msg ("%s: %llu cycles per page", name, (rdtsc () - start) / page_cnt);
+}
+
+void
+test_main (void)
+{
+  static char page[PAGE_SIZE];
+  int handle, size, n;
+  void *map;
+  size_t i;
+
+  for (i = 0; i < INDEX_PAGES; i++)
+    memset (index + i * PAGE_SIZE, i, PAGE_SIZE);
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  size = filesize (handle);
+  while ((n = read (handle, page, sizeof page)) > 0)
+    for (i = 0; i < (size_t) n; i++)
+      expected = expected * 31 + (unsigned char) page[i];
+  CHECK ((map = mmap (ACTUAL, size, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"large.txt\"");
+  stream ("normal", size);
+  munmap (map);
+
+  CHECK ((map = mmap (ACTUAL, size, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"large.txt\" again");
+  CHECK (madvise (ACTUAL, size, MADV_SEQUENTIAL) == 0, "madvise SEQUENTIAL");
+  stream ("sequential", size);
+  munmap (map);
+  close (handle);
+}
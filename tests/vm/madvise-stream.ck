@@ -0,0 +1,29 @@
+# -*- perl -*-
+
+# The expected output looks like this:
+#
+# (madvise-stream) begin
+# (madvise-stream) open "large.txt"
+# (madvise-stream) mmap "large.txt"
+# (madvise-stream) normal: 921503 cycles per page
+# (madvise-stream) mmap "large.txt" again
+# (madvise-stream) madvise SEQUENTIAL
+# (madvise-stream) sequential: 310442 cycles per page
+# (madvise-stream) end
+#
+# The cycle counts differ from run to run.
+
+use strict;
+use warnings;
+use tests::tests;
+
+check_expected_lines (
+    '(madvise-stream) begin',
+    '(madvise-stream) open "large.txt"',
+    '(madvise-stream) mmap "large.txt"',
+    qr/^\(madvise-stream\) normal: \d+ cycles per page$/,
+    '(madvise-stream) mmap "large.txt" again',
+    '(madvise-stream) madvise SEQUENTIAL',
+    qr/^\(madvise-stream\) sequential: \d+ cycles per page$/,
+    '(madvise-stream) end');
+pass;
@@ -0,0 +1,60 @@
+/* Checks the madvise hints: bad arguments are rejected, WILLNEED
+   and DONTNEED work on anonymous memory (dropped pages read back
+   as zeros), and DONTNEED on a writable file mapping writes the
+   changes back before dropping the page. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 16
+#define ACTUAL ((char *) 0x10000000)
+
+static char buf[PAGE_CNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  int handle;
+  void *map;
+  size_t i;
+  char c;
+
+  CHECK (madvise (buf + 1, PAGE_SIZE, MADV_NORMAL) == -1,
+         "madvise unaligned address");
+  CHECK (madvise (buf, PAGE_SIZE, 42) == -1, "madvise bad advice");
+
+  /* Anonymous memory: the dropped half reads back as zeros. */
+  CHECK (madvise (buf, sizeof buf, MADV_WILLNEED) == 0, "madvise WILLNEED");
+  memset (buf, 0xa5, sizeof buf);
+  CHECK (madvise (buf, sizeof buf / 2, MADV_DONTNEED) == 0,
+         "madvise DONTNEED");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != (i < sizeof buf / 2 ? 0 : (char) 0xa5))
+      fail ("byte %zu of buf is %02hhx after DONTNEED", i, buf[i]);
+
+  /* File mapping: the change survives dropping the page. */
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, PAGE_SIZE, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_SEQUENTIAL) == 0,
+         "madvise SEQUENTIAL");
+  if (memcmp (ACTUAL, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+  ACTUAL[0] = '#';
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_DONTNEED) == 0,
+         "madvise DONTNEED on mapping");
+  if (ACTUAL[0] != '#' || memcmp (ACTUAL + 1, sample + 1, strlen (sample) - 1))
+    fail ("mmap'd file has bad data after DONTNEED");
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_RANDOM) == 0, "madvise RANDOM");
+  munmap (map);
+
+  seek (handle, 0);
+  CHECK (read (handle, &c, 1) == 1, "read \"sample.txt\"");
+  if (c != '#')
+    fail ("change did not reach the file");
+  close (handle);
+}
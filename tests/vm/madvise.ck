@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'XEOF']);
+(madvise) begin
+(madvise) madvise unaligned address
+(madvise) madvise bad advice
+(madvise) madvise WILLNEED
+(madvise) madvise DONTNEED
+(madvise) open "sample.txt"
+(madvise) mmap "sample.txt"
+(madvise) madvise SEQUENTIAL
+(madvise) madvise DONTNEED on mapping
+(madvise) madvise RANDOM
+(madvise) read "sample.txt"
+(madvise) end
+XEOF
+pass;
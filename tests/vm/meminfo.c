@@ -0,0 +1,64 @@
+/* Checks the meminfo system call: touching anonymous pages and
+   reading a file mapping show up in the calling process's
+   resident counts and fault counts, the system-wide totals cover
+   the process, and unmapping the file drops its pages again. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+#define ACTUAL ((char *) 0x10000000)
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct meminfo before, after, all;
+  int handle;
+  void *map;
+  size_t i;
+
+  CHECK (meminfo (MEMINFO_SELF, &before) == 0, "meminfo self");
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = 1;
+  CHECK (meminfo (MEMINFO_SELF, &after) == 0, "meminfo after touching bss");
+  /* The first page of BUF may share a page with other data. */
+  if (after.rss_anon < before.rss_anon + PAGE_CNT - 1)
+    fail ("%lu anonymous pages resident, expected at least %lu",
+          after.rss_anon, before.rss_anon + PAGE_CNT - 1);
+  if (after.minor_faults < before.minor_faults + PAGE_CNT - 1)
+    fail ("%lu minor faults, expected at least %lu",
+          after.minor_faults, before.minor_faults + PAGE_CNT - 1);
+  if (after.committed < PAGE_CNT)
+    fail ("only %lu pages committed", after.committed);
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, PAGE_SIZE, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  before = after;
+  if (ACTUAL[0] == '\0')
+    fail ("sample.txt starts with a null byte");
+  CHECK (meminfo (MEMINFO_SELF, &after) == 0, "meminfo after reading mapping");
+  if (after.rss_file != before.rss_file + 1)
+    fail ("%lu file pages resident, expected %lu",
+          after.rss_file, before.rss_file + 1);
+  if (after.major_faults != before.major_faults + 1)
+    fail ("%lu major faults, expected %lu",
+          after.major_faults, before.major_faults + 1);
+
+  CHECK (meminfo (MEMINFO_ALL, &all) == 0, "meminfo all");
+  if (all.rss_anon < after.rss_anon || all.rss_file < after.rss_file
+      || all.minor_faults < after.minor_faults)
+    fail ("system-wide totals smaller than this process's counts");
+  CHECK (meminfo (12345, &all) == -1, "meminfo of a missing process");
+
+  munmap (map);
+  CHECK (meminfo (MEMINFO_SELF, &after) == 0, "meminfo after munmap");
+  if (after.rss_file != before.rss_file)
+    fail ("%lu file pages resident after munmap, expected %lu",
+          after.rss_file, before.rss_file);
+  close (handle);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(meminfo) begin
+(meminfo) meminfo self
+(meminfo) meminfo after touching bss
+(meminfo) open "sample.txt"
+(meminfo) mmap "sample.txt"
+(meminfo) meminfo after reading mapping
+(meminfo) meminfo all
+(meminfo) meminfo of a missing process
+(meminfo) meminfo after munmap
+(meminfo) end
+EOF
+pass;
@@ -0,0 +1,91 @@
+/* Creates a 4 MB file, then maps it and reads it from start to end
+   twice, and once more in a shuffled page order.  Reports the
+   cycles spent per page for each pass: sequential passes are
+   served by readahead, the shuffled one is not.  The "Readahead:"
+   line reported at power off shows how many pages were read ahead
+   and how many of them were used. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/cycles.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 1024
+#define FILE_SIZE (PAGE_CNT * PAGE_SIZE)
+
+static char page[PAGE_SIZE];
+static unsigned order[PAGE_CNT];
+
+/* Byte at offset OFS of page IDX of the file. */
+static char
+pattern (size_t idx, size_t ofs)
+{
+  return idx * 13 + ofs / 64;
+}
+
+/* Reads the pages of MAP in ORDER, checks a byte of every 64-byte
+   block, and reports the cycles spent per page. */
+static void
+stream (const char *name, const char *map, const unsigned *order)
+{
+  unsigned long long start = rdtsc ();
+  size_t i, j;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      const char *p = map + order[i] * PAGE_SIZE;
+      for (j = 0; j < PAGE_SIZE; j += 64)
+        if (p[j] != pattern (order[i], j))
+          fail ("%s: byte %zu of page %u is wrong", name, j, order[i]);
+    }
+  msg ("%s: %llu cycles per page", name, (rdtsc () - start) / PAGE_CNT);
+}
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  void *map;
+  size_t i, j;
+
+  CHECK (create ("stream.dat", FILE_SIZE), "create \"stream.dat\"");
+  CHECK ((handle = open ("stream.dat")) > 1, "open \"stream.dat\"");
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      for (j = 0; j < PAGE_SIZE; j++)
+        page[j] = pattern (i, j);
+      if (write (handle, page, PAGE_SIZE) != PAGE_SIZE)
+        fail ("write of page %zu failed", i);
+    }
+  msg ("wrote %d pages", PAGE_CNT);
+
+  for (i = 0; i < PAGE_CNT; i++)
+    order[i] = i;
+  CHECK ((map = mmap (actual, FILE_SIZE, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"stream.dat\"");
+  stream ("sequential", actual, order);
+  munmap (map);
+
+  CHECK ((map = mmap (actual, FILE_SIZE, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"stream.dat\" again");
+  stream ("sequential again", actual, order);
+  munmap (map);
+
+  random_init (0);
+  for (i = PAGE_CNT - 1; i > 0; i--)
+    {
+      size_t k = random_ulong () % (i + 1);
+      unsigned t = order[i];
+      order[i] = order[k];
+      order[k] = t;
+    }
+  CHECK ((map = mmap (actual, FILE_SIZE, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"stream.dat\" once more");
+  stream ("shuffled", actual, order);
+  munmap (map);
+  close (handle);
+}
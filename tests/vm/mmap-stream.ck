@@ -0,0 +1,35 @@
+# -*- perl -*-
+
+# The expected output looks like this:
+#
+# (mmap-stream) begin
+# (mmap-stream) create "stream.dat"
+# (mmap-stream) open "stream.dat"
+# (mmap-stream) wrote 1024 pages
+# (mmap-stream) mmap "stream.dat"
+# (mmap-stream) sequential: 41952 cycles per page
+# (mmap-stream) mmap "stream.dat" again
+# (mmap-stream) sequential again: 40105 cycles per page
+# (mmap-stream) mmap "stream.dat" once more
+# (mmap-stream) shuffled: 187310 cycles per page
+# (mmap-stream) end
+#
+# The cycle counts differ from run to run.
+
+use strict;
+use warnings;
+use tests::tests;
+
+check_expected_lines (
+    '(mmap-stream) begin',
+    '(mmap-stream) create "stream.dat"',
+    '(mmap-stream) open "stream.dat"',
+    '(mmap-stream) wrote 1024 pages',
+    '(mmap-stream) mmap "stream.dat"',
+    qr/^\(mmap-stream\) sequential: \d+ cycles per page$/,
+    '(mmap-stream) mmap "stream.dat" again',
+    qr/^\(mmap-stream\) sequential again: \d+ cycles per page$/,
+    '(mmap-stream) mmap "stream.dat" once more',
+    qr/^\(mmap-stream\) shuffled: \d+ cycles per page$/,
+    '(mmap-stream) end');
+pass;
@@ -0,0 +1,44 @@
+/* Checks msync: bad arguments are rejected, and MS_SYNC writes a
+   change made through a file mapping to the file while the file
+   is still mapped, so that read() sees it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  int handle, reader;
+  void *map;
+  char c;
+
+  CHECK (msync (ACTUAL, PAGE_SIZE, MS_SYNC) == -1, "msync unmapped range");
+  CHECK (msync (ACTUAL + 1, PAGE_SIZE, MS_SYNC) == -1,
+         "msync unaligned address");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, PAGE_SIZE, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK (msync (ACTUAL, PAGE_SIZE, MS_SYNC | MS_ASYNC) == -1,
+         "msync bad flags");
+
+  ACTUAL[0] = '#';
+  CHECK (msync (ACTUAL, PAGE_SIZE, MS_SYNC) == 0, "msync MS_SYNC");
+  CHECK ((reader = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (read (reader, &c, 1) == 1, "read \"sample.txt\"");
+  if (c != '#')
+    fail ("change did not reach the file");
+  if (memcmp (ACTUAL + 1, sample + 1, strlen (sample) - 1))
+    fail ("mmap'd file has bad data after msync");
+
+  CHECK (msync (ACTUAL, PAGE_SIZE, MS_ASYNC) == 0, "msync MS_ASYNC");
+  munmap (map);
+  close (reader);
+  close (handle);
+}
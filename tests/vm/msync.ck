@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync) begin
+(msync) msync unmapped range
+(msync) msync unaligned address
+(msync) open "sample.txt"
+(msync) mmap "sample.txt"
+(msync) msync bad flags
+(msync) msync MS_SYNC
+(msync) open "sample.txt" again
+(msync) read "sample.txt"
+(msync) msync MS_ASYNC
+(msync) end
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Runs a memory hog next to a small working set when RAM and
+   swap together cannot hold both.  The OOM killer must pick the
+   hog, which has by far the largest resident-plus-swap
+   footprint, rather than the well-behaved parent, and the parent
+   must then find its working set intact. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define WORK_CNT 64
+
+static char work[WORK_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  for (i = 0; i < WORK_CNT; i++)
+    work[i * PAGE_SIZE] = i;
+
+  child = fork ("child-hog");
+  if (child == 0)
+    {
+      exec ("child-hog");
+      exit (-1);
+    }
+  msg ("wait for child-hog: %d", wait (child));
+
+  for (i = 0; i < WORK_CNT; i++)
+    if (work[i * PAGE_SIZE] != (char) i)
+      fail ("working set page %zu corrupted", i);
+  msg ("working set intact");
+}
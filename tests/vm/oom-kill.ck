@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(oom-kill) begin
+(oom-kill) wait for child-hog: -1
+(oom-kill) working set intact
+(oom-kill) end
+EOF
+pass;
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-scan-2q) begin
+(page-scan-2q) 8 rounds of 128 hot pages and 1024 scanned pages
+(page-scan-2q) end
+EOF
+pass;
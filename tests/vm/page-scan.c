@@ -0,0 +1,44 @@
+/* Loops over a small working set while making one pass over a
+   buffer larger than memory between loops.  A scan-resistant
+   replacement policy keeps the working set resident across the
+   scans, so the "Exception:" page fault count and the
+   "Replacement:" line reported at power off show how well each
+   policy does.  Built twice, as page-scan (clock) and page-scan-2q
+   (-vm=2q). */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HOT_PAGES 128
+#define SCAN_PAGES 1024
+#define ROUNDS 8
+#define HOT_LOOPS 16
+
+static char hot[HOT_PAGES * PAGE_SIZE];
+static char scan[SCAN_PAGES * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+  int round, loop;
+
+  for (i = 0; i < HOT_PAGES; i++)
+    memset (hot + i * PAGE_SIZE, i, PAGE_SIZE);
+  for (round = 0; round < ROUNDS; round++)
+    {
+      for (loop = 0; loop < HOT_LOOPS; loop++)
+        for (i = 0; i < HOT_PAGES; i++)
+          if (hot[i * PAGE_SIZE + loop] != (char) i)
+            fail ("hot page %zu corrupted in round %d", i, round);
+      for (i = 0; i < SCAN_PAGES; i++)
+        scan[i * PAGE_SIZE] = round;
+    }
+  for (i = 0; i < SCAN_PAGES; i++)
+    if (scan[i * PAGE_SIZE] != ROUNDS - 1)
+      fail ("scan page %zu corrupted", i);
+  msg ("%d rounds of %d hot pages and %d scanned pages",
+       ROUNDS, HOT_PAGES, SCAN_PAGES);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-scan) begin
+(page-scan) 8 rounds of 128 hot pages and 1024 scanned pages
+(page-scan) end
+EOF
+pass;
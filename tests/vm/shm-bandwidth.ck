@@ -0,0 +1,27 @@
+# -*- perl -*-
+
+# The expected output looks like this:
+#
+# (shm-bandwidth) begin
+# (shm-bandwidth) create "shm-buf"
+# (shm-bandwidth) open "shm-buf"
+# (shm-bandwidth) file: 184027 cycles per kB
+# (shm-bandwidth) shm_map "ring"
+# (shm-bandwidth) shm: 20316 cycles per kB
+# (shm-bandwidth) end
+#
+# The cycle counts differ from run to run.
+
+use strict;
+use warnings;
+use tests::tests;
+
+check_expected_lines (
+    '(shm-bandwidth) begin',
+    '(shm-bandwidth) create "shm-buf"',
+    '(shm-bandwidth) open "shm-buf"',
+    qr/^\(shm-bandwidth\) file: \d+ cycles per kB$/,
+    '(shm-bandwidth) shm_map "ring"',
+    qr/^\(shm-bandwidth\) shm: \d+ cycles per kB$/,
+    '(shm-bandwidth) end');
+pass;
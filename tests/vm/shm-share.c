@@ -0,0 +1,57 @@
+/* Shares a named memory segment between a process, its forked
+   child, and an unrelated program that maps the segment by name.
+   Each one sees the others' writes.  The contents outlive the
+   mappings while the segment still has its name, and unlinking
+   the name only succeeds once. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SEG_SIZE (4 * PAGE_SIZE)
+#define SHARED ((char *) 0x10000000)
+#define OTHER ((char *) 0x30000000)
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  CHECK (shm_map ("seg", SEG_SIZE, SHARED) == SHARED, "shm_map \"seg\"");
+  for (i = 0; i < SEG_SIZE; i++)
+    SHARED[i] = i % 251;
+
+  /* A forked child shares the segment instead of copying it. */
+  child = fork ("child");
+  if (child == 0)
+    {
+      for (i = 2; i < SEG_SIZE; i++)
+        if (SHARED[i] != (char) (i % 251))
+          exit (1);
+      SHARED[0] = 'c';
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "forked child sees the segment");
+  CHECK (SHARED[0] == 'c', "parent sees the forked child's write");
+
+  child = fork ("child-shm");
+  if (child == 0)
+    {
+      exec ("child-shm");
+      exit (-1);
+    }
+  msg ("wait for child-shm: %d", wait (child));
+  CHECK (SHARED[1] == 's', "parent sees child-shm's write");
+
+  munmap (SHARED);
+  CHECK (shm_map ("seg", SEG_SIZE, SHARED) == SHARED, "shm_map \"seg\" again");
+  CHECK (SHARED[0] == 'c' && SHARED[1] == 's', "contents kept across unmap");
+  CHECK (shm_map ("seg", 2 * SEG_SIZE, OTHER) == NULL,
+         "shm_map past the end of \"seg\" fails");
+
+  CHECK (shm_unlink ("seg") == 0, "shm_unlink \"seg\"");
+  CHECK (shm_unlink ("seg") == -1, "shm_unlink \"seg\" again fails");
+  munmap (SHARED);
+}
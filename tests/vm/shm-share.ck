@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-share) begin
+(shm-share) shm_map "seg"
+(shm-share) forked child sees the segment
+(shm-share) parent sees the forked child's write
+(shm-share) wait for child-shm: 0
+(shm-share) parent sees child-shm's write
+(shm-share) shm_map "seg" again
+(shm-share) contents kept across unmap
+(shm-share) shm_map past the end of "seg" fails
+(shm-share) shm_unlink "seg"
+(shm-share) shm_unlink "seg" again fails
+(shm-share) end
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Shared body of the tests that stream through a buffer larger
+   than memory: writes every page front to back, then reads the
+   buffer back front to back a number of times, comparing each page
+   against what was written. */
+
+#include "tests/vm/swap-buf.h"
+#include <string.h>
+#include "tests/lib.h"
+
+static char buf[SWAP_BUF_PAGES * PAGE_SIZE];
+
+/* Writes each page of the buffer with FILL, then reads the buffer
+   back PASSES times and fails if any page changed. */
+void
+swap_buf_run (swap_buf_fill_func *fill, int passes)
+{
+  static char expected[PAGE_SIZE];
+  size_t i;
+  int pass;
+
+  for (i = 0; i < SWAP_BUF_PAGES; i++)
+    fill (i, buf + i * PAGE_SIZE);
+  msg ("wrote %d pages", SWAP_BUF_PAGES);
+
+  for (pass = 0; pass < passes; pass++)
+    {
+      for (i = 0; i < SWAP_BUF_PAGES; i++)
+        {
+          fill (i, expected);
+          if (memcmp (buf + i * PAGE_SIZE, expected, PAGE_SIZE))
+            fail ("page %zu corrupted in pass %d", i, pass);
+        }
+      msg ("read back %d pages", SWAP_BUF_PAGES);
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef TESTS_VM_SWAP_BUF_H
+#define TESTS_VM_SWAP_BUF_H 1
+
+#include <stddef.h>
+
+#define PAGE_SIZE 4096
+#define SWAP_BUF_PAGES 1536     /* More pages than fit in memory. */
+
+/* Fills PAGE with the contents expected for page I. */
+typedef void swap_buf_fill_func (size_t i, char *page);
+
+void swap_buf_run (swap_buf_fill_func *fill, int passes);
+
+#endif /* tests/vm/swap-buf.h */
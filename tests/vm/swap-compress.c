@@ -0,0 +1,37 @@
+/* Fills a buffer larger than memory with compressible records, a
+   few incompressible pages mixed in, and reads it back twice.
+   Compressible pages should stay in the compressed swap cache, so
+   the "Zswap:" line reported at power off shows the hit rate and
+   compression ratio and the "Swap disk:" line how few pages had to
+   go to the disk. */
+
+#include "tests/vm/swap-buf.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Fills page I.  Every 16th page gets pseudo-random bytes that
+   do not compress; the rest hold a repeating 64-byte record. */
+static void
+fill_page (size_t i, char *page)
+{
+  size_t j;
+
+  if (i % 16 == 0)
+    {
+      unsigned state = i + 1;
+      for (j = 0; j < PAGE_SIZE; j++)
+        {
+          state = state * 1103515245 + 12345;
+          page[j] = state >> 16;
+        }
+    }
+  else
+    for (j = 0; j < PAGE_SIZE; j++)
+      page[j] = j % 64 < 8 ? (char) i : (char) (j % 64);
+}
+
+void
+test_main (void)
+{
+  swap_buf_run (fill_page, 2);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-compress) begin
+(swap-compress) wrote 1536 pages
+(swap-compress) read back 1536 pages
+(swap-compress) read back 1536 pages
+(swap-compress) end
+EOF
+pass;
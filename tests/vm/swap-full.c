@@ -0,0 +1,33 @@
+/* Forks a child that touches more memory than RAM and swap
+   together.  Once swap is exhausted the child's page fault must
+   fail and the child must be killed, rather than the kernel
+   writing to a bogus swap slot.  The parent then checks that it
+   still runs normally with the child's swap slots returned. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT (16 * 256)
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  pid_t child = fork ("child");
+  if (child == 0)
+    {
+      size_t i;
+
+      for (i = 0; i < PAGE_CNT; i++)
+        buf[i * PAGE_SIZE] = 1;
+      exit (0);
+    }
+  CHECK (wait (child) == -1, "child killed when swap is full");
+
+  memset (buf, 'x', 64 * PAGE_SIZE);
+  CHECK (buf[64 * PAGE_SIZE - 1] == 'x', "parent still runs");
+}
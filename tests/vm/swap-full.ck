@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(swap-full) begin
+child: exit(-1)
+(swap-full) child killed when swap is full
+(swap-full) parent still runs
+(swap-full) end
+swap-full: exit(0)
+EOF
+pass;
@@ -0,0 +1,24 @@
+/* Writes a buffer larger than memory front to back, then reads it
+   back front to back twice.  Sequential eviction lets neighbouring
+   pages go to swap together, and sequential faults let swap-in read
+   them back ahead of use.  The disk read/write counts, timer ticks
+   and "Swap:" line reported at power off measure the sectors moved,
+   the elapsed time and how much readahead was used. */
+
+#include <string.h>
+#include "tests/vm/swap-buf.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Fills page I with the byte I. */
+static void
+fill_page (size_t i, char *page)
+{
+  memset (page, i, PAGE_SIZE);
+}
+
+void
+test_main (void)
+{
+  swap_buf_run (fill_page, 2);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-seq) begin
+(swap-seq) wrote 1536 pages
+(swap-seq) read back 1536 pages
+(swap-seq) read back 1536 pages
+(swap-seq) end
+EOF
+pass;
@@ -0,0 +1,29 @@
+/* Runs many copies of the same executable at once.  Their
+   read-only code pages come from the same frames instead of being
+   read from disk by every process; the "Text:" statistics reported
+   at power off show how many pages were loaded and shared. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 16
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) {
+    children[i] = fork ("child-text");
+    if (children[i] == 0) {
+      if (exec ("child-text") == -1)
+        fail ("failed to exec child-text");
+    }
+  }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (children[i]) != 0x42)
+      fail ("child %d returned wrong exit status", i);
+  msg ("waited for %d children", CHILD_CNT);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(text-share) begin
+(text-share) waited for 16 children
+(text-share) end
+EOF
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(thp-touch-4k) begin
+(thp-touch-4k) touch 131072 pages
+(thp-touch-4k) read back
+(thp-touch-4k) end
+EOF
+
+# Without -thp every fault maps a 4 kB page and no THP statistics are
+# reported.
+our ($test);
+fail "THP statistics reported without -thp\n"
+  if grep (/^THP: /, read_text_file ("$test.output"));
+pass;
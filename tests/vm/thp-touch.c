@@ -0,0 +1,33 @@
+/* Writes one byte to every page of a 512 MB array and reads them
+   back.  Run as thp-touch (kernel option -thp, a single fault maps
+   each 2 MB block) and thp-touch-4k (a fault per 4 kB page); the
+   "Exception:" page fault count, the "THP:" line and the "Timer:"
+   ticks reported at power off compare the two. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (512 * 1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char big[SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  msg ("touch %d pages", SIZE / PAGE_SIZE);
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    big[i] = i / PAGE_SIZE + 1;
+
+  msg ("read back");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    {
+      if (big[i] != (char) (i / PAGE_SIZE + 1))
+        fail ("byte %zu is %d, expected %d", i, big[i], (char) (i / PAGE_SIZE + 1));
+      if (big[i + PAGE_SIZE / 2] != 0)
+        fail ("byte %zu is %d, expected 0", i + PAGE_SIZE / 2, big[i + PAGE_SIZE / 2]);
+    }
+}
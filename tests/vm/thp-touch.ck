@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(thp-touch) begin
+(thp-touch) touch 131072 pages
+(thp-touch) read back
+(thp-touch) end
+EOF
+
+# The 512 MB array spans 256 2 MB blocks.  Only the partial blocks at
+# either end of the array may fall back to 4 kB pages, so nearly all
+# of them must have been mapped by a single huge page fault.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+my ($thp) = grep (/^THP: /, @output);
+fail "missing THP statistics line\n" if !defined $thp;
+my ($mapped) = $thp =~ /^THP: (\d+) faults mapped 2 MB pages/
+  or fail "malformed THP statistics line: $thp\n";
+fail "only $mapped faults mapped 2 MB pages, expected at least 200\n"
+  if $mapped < 200;
+pass;
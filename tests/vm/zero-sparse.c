@@ -0,0 +1,39 @@
+/* Touches 256 MB of sparse arrays: reads one byte from every page,
+   writes every 16th page and checks that the rest still read as
+   zeros.  Pages that are only read should all map the shared zero
+   page, so the "Frames:" line reported at power off shows a peak
+   close to the number of written pages rather than 256 MB. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT (256 * 1024 * 1024 / PAGE_SIZE)
+#define STRIDE 16
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != 0)
+      fail ("page %zu is not zero", i);
+  msg ("read %d zero pages", PAGE_CNT);
+
+  for (i = 0; i < PAGE_CNT; i += STRIDE)
+    buf[i * PAGE_SIZE + PAGE_SIZE / 2] = (char) (i / STRIDE + 1);
+  msg ("wrote %d pages", PAGE_CNT / STRIDE);
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      char expected = i % STRIDE == 0 ? (char) (i / STRIDE + 1) : 0;
+      if (buf[i * PAGE_SIZE] != 0
+          || buf[i * PAGE_SIZE + PAGE_SIZE / 2] != expected
+          || buf[i * PAGE_SIZE + PAGE_SIZE - 1] != 0)
+        fail ("page %zu corrupted", i);
+    }
+  msg ("verified %d pages", PAGE_CNT);
+}
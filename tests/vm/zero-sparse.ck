@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-sparse) begin
+(zero-sparse) read 65536 zero pages
+(zero-sparse) wrote 4096 pages
+(zero-sparse) verified 65536 pages
+(zero-sparse) end
+EOF
+pass;
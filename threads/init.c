@@ -21,6 +21,7 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -31,6 +32,8 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/ksm.h"
+#include "vm/thp.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -140,6 +143,8 @@ bss_init (void) {
 	memset (&_start_bss, 0, &_end_bss - &_start_bss);
 }
 
+#define CR0_WP 0x00010000      /* Write-Protect enable in kernel mode. */
+
 /* Populates the page table with the kernel virtual mapping,
  * and then sets up the CPU to use the new page directory.
  * Points base_pml4 to the pml4 it creates. */
@@ -150,21 +155,47 @@ paging_init (uint64_t mem_end) {
 	pml4 = base_pml4 = palloc_get_page (PAL_ASSERT | PAL_ZERO);
 
 	extern char start, _end_kernel_text;
+	uint64_t text_start = (uint64_t) &start;
+	uint64_t text_end = (uint64_t) &_end_kernel_text;
 	// Maps physical address [0 ~ mem_end] to
 	//   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+	for (uint64_t pa = 0; pa < mem_end; ) {
 		uint64_t va = (uint64_t) ptov(pa);
 
+		// Use one 2 MB page where the whole aligned chunk is RAM and
+		// lies either entirely inside or entirely outside the kernel
+		// text, which saves a page table and 511 TLB entries per chunk.
+		// The first chunk holds the legacy BIOS/VGA ranges, whose
+		// memory types differ, so it keeps 4 kB pages.
+		if (pa != 0 && (pa & HUGE_PGMASK) == 0 && pa + HUGE_PGSIZE <= mem_end) {
+			bool in_text = text_start <= va && va + HUGE_PGSIZE <= text_end;
+			bool no_text = va + HUGE_PGSIZE <= text_start || text_end <= va;
+
+			if (in_text || no_text) {
+				perm = PTE_P | PTE_PS | (in_text ? 0 : PTE_W);
+				if ((pte = pml4_pde_walk (pml4, va, 1)) != NULL)
+					*pte = pa | perm;
+				pa += HUGE_PGSIZE;
+				continue;
+			}
+		}
+
 		perm = PTE_P | PTE_W;
-		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
+		if (text_start <= va && va < text_end)
 			perm &= ~PTE_W;
 
 		if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
 			*pte = pa | perm;
+		pa += PGSIZE;
 	}
 
-	// reload cr3
+	// enable PCIDs, then reload cr3
+	pcid_init ();
 	pml4_activate(0);
+
+	// Make read-only user pages read-only for the kernel too
+	// (CR0.WP), so that kernel writes to copy-on-write pages fault.
+	lcr0 (rcr0 () | CR0_WP);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -226,6 +257,20 @@ parse_options (char **argv) {
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-vm"))
+			vm_set_policy (value);
+		else if (!strcmp (name, "-ksm"))
+			ksm_enable ();
+		else if (!strcmp (name, "-kswapd"))
+			vm_enable_kswapd ();
+		else if (!strcmp (name, "-fault-around"))
+			vm_set_fault_around (atoi (value));
+		else if (!strcmp (name, "-thp"))
+			thp_enable ();
+		else if (!strcmp (name, "-overcommit"))
+			vm_set_overcommit (value);
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -328,6 +373,14 @@ usage (void) {
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -vm=clock|2q       Choose the page replacement policy.\n"
+			"  -ksm               Merge identical anonymous pages in the background.\n"
+			"  -kswapd            Reclaim frames in the background below a watermark.\n"
+			"  -fault-around=N    Map up to N neighbouring file pages per fault.\n"
+			"  -thp               Map large anonymous regions with 2 MB pages.\n"
+			"  -overcommit=POLICY Limit reserved anonymous memory (always|heuristic|never).\n"
 #endif
 			);
 	power_off ();
@@ -354,6 +407,8 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	mmu_print_stats ();
+	palloc_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -362,4 +417,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
@@ -1,35 +1,208 @@
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* Process-context identifiers (PCIDs).
+
+   With CR4.PCIDE set, the low 12 bits of CR3 name the address
+   space, TLB entries are tagged with it, and a CR3 load with bit 63
+   set keeps the entries of every PCID.  Switching back to a process
+   then finds its translations still cached.
+
+   Each pml4 gets the PCID derived from the physical page it lives
+   in, so no allocation is needed.  pcid_owner[] records which pml4
+   last loaded each PCID with a flush.  A pml4 may keep its cached
+   entries only while it is still the owner.  When two pml4s collide
+   on a PCID, or a pml4 is freed and its page reused, ownership
+   changes and the next load flushes that PCID.  PCID 0 belongs to
+   base_pml4, whose mappings never change after boot. */
+#define CR4_PCIDE (1UL << 17)           /* Enable PCIDs. */
+#define CR3_NOFLUSH (1UL << 63)         /* Keep TLB entries of the PCID. */
+#define PCID_CNT 4096                   /* Number of PCIDs. */
+
+static bool pcid_enabled;               /* CR4.PCIDE is set. */
+static bool invpcid_enabled;            /* INVPCID is available. */
+static uint64_t *pcid_owner[PCID_CNT];  /* pml4 whose entries a PCID holds. */
+
+/* Statistics. */
+static long long cr3_load_cnt;          /* # of CR3 loads. */
+static long long cr3_flush_cnt;         /* # of those that flushed. */
+
+static unsigned pml4_pcid (uint64_t *pml4);
+static void pml4_invalidate (uint64_t *pml4, const void *va);
+
+/* Page table pages.
+
+   Every entry that points to a page table (at any level) keeps,
+   in bits the MMU ignores, the number of non-zero entries in that
+   table; see PTE_CNT().  A walk that creates a mapping counts the
+   entry it returns if it is still zero, so the caller must fill it
+   in.  Teardown uses the counts to stop scanning a table as soon
+   as its last entry is found and to skip empty subtrees, and
+   clears what it visits, so torn down tables come back zeroed.
+
+   Such tables go to pt_cache, which also holds pages zeroed ahead
+   of time by the idle thread (pt_cache_refill()), so creating page
+   tables rarely waits for palloc or for a memset.  The cache is a
+   stack linked through the first word of each page. */
+#define PT_CACHE_MAX 64                 /* Pages kept at most. */
+
+static uint64_t *pt_cache;              /* Top of the stack. */
+static size_t pt_cache_cnt;             /* Pages in the stack. */
+
+/* Statistics. */
+static long long pt_hit_cnt;            /* # of tables taken from pt_cache. */
+static long long pt_miss_cnt;           /* # of tables zeroed on demand. */
+static long long pt_recycle_cnt;        /* # of tables put back in pt_cache. */
+static long long pde_split_cnt;         /* # of 2 MB pages split into 4 kB. */
+
+/* Returns a zeroed page for a page table, or a null pointer if out
+ * of memory. */
+static uint64_t *
+pt_alloc (void) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t *pt = pt_cache;
+	if (pt != NULL) {
+		pt_cache = (uint64_t *) pt[0];
+		pt_cache_cnt--;
+		pt_hit_cnt++;
+	}
+	intr_set_level (old_level);
+
+	if (pt != NULL)
+		pt[0] = 0;
+	else {
+		pt_miss_cnt++;
+		pt = palloc_get_page (PAL_ZERO);
+	}
+	return pt;
+}
+
+/* Pushes zeroed page PT on pt_cache.  Returns false if the cache
+ * is full, in which case the caller still owns PT. */
+static bool
+pt_cache_push (uint64_t *pt) {
+	enum intr_level old_level = intr_disable ();
+	bool pushed = pt_cache_cnt < PT_CACHE_MAX;
+	if (pushed) {
+		pt[0] = (uint64_t) pt_cache;
+		pt_cache = pt;
+		pt_cache_cnt++;
+	}
+	intr_set_level (old_level);
+	return pushed;
+}
+
+/* Releases page table PT, which must be all zeroes. */
+static void
+pt_free (uint64_t *pt) {
+	if (pt_cache_push (pt))
+		pt_recycle_cnt++;
+	else
+		palloc_free_page (pt);
+}
+
+/* Adds one zeroed page to the page table cache.  Returns false if
+ * the cache is full or no page could be had without blocking.
+ * Called by the idle thread, so it never sleeps. */
+bool
+pt_cache_refill (void) {
+	if (pt_cache_cnt >= PT_CACHE_MAX)
+		return false;
+
+	uint64_t *pt = palloc_get_page (PAL_ZERO | PAL_NOWAIT);
+	if (pt == NULL)
+		return false;
+	if (!pt_cache_push (pt)) {
+		/* Filled up meanwhile.  Keep the page anyway rather than
+		 * risk blocking on the pool lock to return it. */
+		enum intr_level old_level = intr_disable ();
+		pt[0] = (uint64_t) pt_cache;
+		pt_cache = pt;
+		pt_cache_cnt++;
+		intr_set_level (old_level);
+		return false;
+	}
+	return true;
+}
+
+/* Replaces the 2 MB mapping in page directory entry PDE by a page
+ * table that maps the same frames, 4 kB at a time, with the same
+ * permissions.  The translation itself does not change, so a stale
+ * 2 MB TLB entry stays correct until the caller modifies one of the
+ * new PTEs and flushes it.  Returns false if out of memory. */
+static bool
+pde_split (uint64_t *pde) {
+	uint64_t *pt = pt_alloc ();
+	if (pt == NULL)
+		return false;
+
+	uint64_t pa = HUGE_PTE_ADDR (*pde);
+	uint64_t flags = *pde & (PTE_P | PTE_W | PTE_U | PTE_A | PTE_D);
+	for (unsigned i = 0; i < HUGE_PGCNT; i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_CNT_ONE * HUGE_PGCNT | PTE_U | PTE_W | PTE_P;
+	pde_split_cnt++;
+	return true;
+}
+
+/* Counts ENTRY, about to be filled in by a creating walk, in the
+ * population count kept in PARENT if ENTRY is still zero. */
+static uint64_t *
+pte_reserve (uint64_t *entry, uint64_t *parent, int create) {
+	if (create && *entry == 0)
+		*parent += PTE_CNT_ONE;
+	return entry;
+}
+
+/* PD_CNT points to the PDPE that refers to page directory PDP. */
 static uint64_t *
-pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
+pgdir_walk (uint64_t *pdp, uint64_t *pd_cnt, const uint64_t va, int create,
+		bool want_pde) {
 	int idx = PDX (va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
+		if (want_pde)
+			return pte_reserve (&pdp[idx], pd_cnt, create);
+		if (((uint64_t) pte & PTE_P) && ((uint64_t) pte & PTE_PS)) {
+			/* Lookups see the 2 MB entry itself; installing a
+			 * 4 kB mapping inside it needs a page table. */
+			if (!create)
+				return &pdp[idx];
+			if (!pde_split (&pdp[idx]))
+				return NULL;
+		}
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
-				if (new_page)
+				uint64_t *new_page = pt_alloc ();
+				if (new_page) {
+					/* A 2 MB entry cleared by pml4_clear_huge_page()
+					 * is not present but already counted. */
+					pte_reserve (&pdp[idx], pd_cnt, create);
 					pdp[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
-				else
+				} else
 					return NULL;
 			} else
 				return NULL;
 		}
-		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
+		return pte_reserve (ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va)),
+				&pdp[idx], create);
 	}
 	return NULL;
 }
 
+/* PDP_CNT points to the PML4E that refers to PDPE. */
 static uint64_t *
-pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
+pdpe_walk (uint64_t *pdpe, uint64_t *pdp_cnt, const uint64_t va, int create,
+		bool want_pde) {
 	uint64_t *pte = NULL;
 	int idx = PDPE (va);
 	int allocated = 0;
@@ -37,32 +210,29 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 		uint64_t *pde = (uint64_t *) pdpe[idx];
 		if (!((uint64_t) pde & PTE_P)) {
 			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
+				uint64_t *new_page = pt_alloc ();
 				if (new_page) {
 					pdpe[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+					*pdp_cnt += PTE_CNT_ONE;
 					allocated = 1;
 				} else
 					return NULL;
 			} else
 				return NULL;
 		}
-		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create);
+		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), &pdpe[idx], va, create,
+				want_pde);
 	}
 	if (pte == NULL && allocated) {
-		palloc_free_page ((void *) ptov (PTE_ADDR (pdpe[idx])));
+		pt_free ((void *) ptov (PTE_ADDR (pdpe[idx])));
 		pdpe[idx] = 0;
+		*pdp_cnt -= PTE_CNT_ONE;
 	}
 	return pte;
 }
 
-/* Returns the address of the page table entry for virtual
- * address VADDR in page map level 4, pml4.
- * If PML4E does not have a page table for VADDR, behavior depends
- * on CREATE.  If CREATE is true, then a new page table is
- * created and a pointer into it is returned.  Otherwise, a null
- * pointer is returned. */
-uint64_t *
-pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
+static uint64_t *
+pml4_walk (uint64_t *pml4e, const uint64_t va, int create, bool want_pde) {
 	uint64_t *pte = NULL;
 	int idx = PML4 (va);
 	int allocated = 0;
@@ -70,7 +240,7 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 		uint64_t *pdpe = (uint64_t *) pml4e[idx];
 		if (!((uint64_t) pdpe & PTE_P)) {
 			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
+				uint64_t *new_page = pt_alloc ();
 				if (new_page) {
 					pml4e[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
 					allocated = 1;
@@ -79,15 +249,43 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
-		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create);
+		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), &pml4e[idx], va, create,
+				want_pde);
 	}
 	if (pte == NULL && allocated) {
-		palloc_free_page ((void *) ptov (PTE_ADDR (pml4e[idx])));
+		pt_free ((void *) ptov (PTE_ADDR (pml4e[idx])));
 		pml4e[idx] = 0;
 	}
 	return pte;
 }
 
+/* Returns the address of the page table entry for virtual
+ * address VADDR in page map level 4, pml4.
+ * If PML4E does not have a page table for VADDR, behavior depends
+ * on CREATE.  If CREATE is true, then a new page table is
+ * created and a pointer into it is returned.  Otherwise, a null
+ * pointer is returned.
+ * If VADDR lies in a 2 MB page, the returned entry is the page
+ * directory entry that maps it (see is_huge_pte()), unless CREATE
+ * is true, in which case the 2 MB page is first split into 4 kB
+ * pages.
+ * With CREATE, an empty entry returned is already counted as in
+ * use, so the caller must fill it in. */
+uint64_t *
+pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
+	return pml4_walk (pml4e, va, create, false);
+}
+
+/* Returns the address of the page directory entry for virtual
+ * address VADDR in page map level 4, pml4, creating the upper
+ * levels if CREATE is true.  The entry may be empty, point to a
+ * page table, or map a 2 MB page.  As for pml4e_walk(), an empty
+ * entry returned with CREATE must be filled in. */
+uint64_t *
+pml4_pde_walk (uint64_t *pml4, const uint64_t va, int create) {
+	return pml4_walk (pml4, va, create, true);
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -100,11 +298,17 @@ pml4_create (void) {
 	return pml4;
 }
 
+/* The for_each and destroy helpers below get, in CNT, the number
+ * of non-zero entries of the table, and stop once all are seen. */
+
 static bool
-pt_for_each (uint64_t *pt, pte_for_each_func *func, void *aux,
+pt_for_each (uint64_t *pt, size_t cnt, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index, unsigned pdx_index) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+	for (unsigned i = 0; cnt > 0 && i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = &pt[i];
+		if (*pte == 0)
+			continue;
+		cnt--;
 		if (((uint64_t) *pte) & PTE_P) {
 			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
 								 ((uint64_t) pdp_index << PDPESHIFT) |
@@ -118,25 +322,39 @@ pt_for_each (uint64_t *pt, pte_for_each_func *func, void *aux,
 }
 
 static bool
-pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
+pgdir_for_each (uint64_t *pdp, size_t cnt, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
+	for (unsigned i = 0; cnt > 0 && i < PGSIZE / sizeof(uint64_t *); i++) {
+		uint64_t pde = pdp[i];
+		if (pde == 0)
+			continue;
+		cnt--;
+		if (pde & PTE_P) {
+			if (pde & PTE_PS) {
+				/* A 2 MB page is reported once, by its PDE. */
+				void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+									 ((uint64_t) pdp_index << PDPESHIFT) |
+									 ((uint64_t) i << PDXSHIFT));
+				if (!func (&pdp[i], va, aux))
+					return false;
+			} else if (!pt_for_each (ptov (PTE_ADDR (pde)), PTE_CNT (pde),
+					func, aux, pml4_index, pdp_index, i))
 				return false;
+		}
 	}
 	return true;
 }
 
 static bool
-pdp_for_each (uint64_t *pdp,
+pdp_for_each (uint64_t *pdp, size_t cnt,
 		pte_for_each_func *func, void *aux, unsigned pml4_index) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pde = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pde) & PTE_P)
-			if (!pgdir_for_each ((uint64_t *) PTE_ADDR (pde), func,
+	for (unsigned i = 0; cnt > 0 && i < PGSIZE / sizeof(uint64_t *); i++) {
+		uint64_t pdpe = pdp[i];
+		if (pdpe == 0)
+			continue;
+		cnt--;
+		if ((pdpe & PTE_P) && PTE_CNT (pdpe) > 0)
+			if (!pgdir_for_each (ptov (PTE_ADDR (pdpe)), PTE_CNT (pdpe), func,
 					 aux, pml4_index, i))
 				return false;
 	}
@@ -147,42 +365,59 @@ pdp_for_each (uint64_t *pdp,
 bool
 pml4_for_each (uint64_t *pml4, pte_for_each_func *func, void *aux) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pdpe = ptov((uint64_t *) pml4[i]);
-		if (((uint64_t) pdpe) & PTE_P)
-			if (!pdp_for_each ((uint64_t *) PTE_ADDR (pdpe), func, aux, i))
+		uint64_t pml4e = pml4[i];
+		if ((pml4e & PTE_P) && PTE_CNT (pml4e) > 0)
+			if (!pdp_for_each (ptov (PTE_ADDR (pml4e)), PTE_CNT (pml4e), func,
+					aux, i))
 				return false;
 	}
 	return true;
 }
 
 static void
-pt_destroy (uint64_t *pt) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pte = ptov((uint64_t *) pt[i]);
-		if (((uint64_t) pte) & PTE_P)
-			palloc_free_page ((void *) PTE_ADDR (pte));
+pt_destroy (uint64_t *pt, size_t cnt) {
+	for (unsigned i = 0; cnt > 0; i++) {
+		ASSERT (i < PGSIZE / sizeof(uint64_t *));
+		if (pt[i] == 0)
+			continue;
+		if (pt[i] & PTE_P)
+			palloc_free_page (ptov (PTE_ADDR (pt[i])));
+		pt[i] = 0;
+		cnt--;
 	}
-	palloc_free_page ((void *) pt);
+	pt_free (pt);
 }
 
 static void
-pgdir_destroy (uint64_t *pdp) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			pt_destroy (PTE_ADDR (pte));
+pgdir_destroy (uint64_t *pdp, size_t cnt) {
+	for (unsigned i = 0; cnt > 0; i++) {
+		ASSERT (i < PGSIZE / sizeof(uint64_t *));
+		uint64_t pde = pdp[i];
+		if (pde == 0)
+			continue;
+		if (pde & PTE_PS) {
+			if (pde & PTE_P)
+				palloc_free_multiple (ptov (HUGE_PTE_ADDR (pde)), HUGE_PGCNT);
+		} else
+			pt_destroy (ptov (PTE_ADDR (pde)), PTE_CNT (pde));
+		pdp[i] = 0;
+		cnt--;
 	}
-	palloc_free_page ((void *) pdp);
+	pt_free (pdp);
 }
 
 static void
-pdpe_destroy (uint64_t *pdpe) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pde = ptov((uint64_t *) pdpe[i]);
-		if (((uint64_t) pde) & PTE_P)
-			pgdir_destroy ((void *) PTE_ADDR (pde));
+pdpe_destroy (uint64_t *pdpe, size_t cnt) {
+	for (unsigned i = 0; cnt > 0; i++) {
+		ASSERT (i < PGSIZE / sizeof(uint64_t *));
+		uint64_t pde = pdpe[i];
+		if (pde == 0)
+			continue;
+		pgdir_destroy (ptov (PTE_ADDR (pde)), PTE_CNT (pde));
+		pdpe[i] = 0;
+		cnt--;
 	}
-	palloc_free_page ((void *) pdpe);
+	pt_free (pdpe);
 }
 
 /* Destroys pml4e, freeing all the pages it references. */
@@ -193,17 +428,102 @@ pml4_destroy (uint64_t *pml4) {
 	ASSERT (pml4 != base_pml4);
 
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
-	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
-	if (((uint64_t) pdpe) & PTE_P)
-		pdpe_destroy ((void *) PTE_ADDR (pdpe));
+	if (pml4[0] & PTE_P)
+		pdpe_destroy (ptov (PTE_ADDR (pml4[0])), PTE_CNT (pml4[0]));
+
+	/* A pml4 allocated in this page later gets the same PCID; it
+	 * must not inherit our TLB entries. */
+	if (pcid_enabled && pcid_owner[pml4_pcid (pml4)] == pml4)
+		pcid_owner[pml4_pcid (pml4)] = NULL;
 	palloc_free_page ((void *) pml4);
 }
 
+/* Enables PCIDs if the CPU supports them.  Must be called while
+ * the PCID field of CR3 is 0, before the first pml4_activate(). */
+void
+pcid_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid (1, 0, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1 << 17)))
+		return;
+	cpuid (0, 0, &eax, &ebx, &ecx, &edx);
+	if (eax >= 7) {
+		cpuid (7, 0, &eax, &ebx, &ecx, &edx);
+		invpcid_enabled = (ebx & (1 << 10)) != 0;
+	}
+
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_enabled = true;
+}
+
+/* Returns the PCID that PML4 uses.  Never 0, which is reserved
+ * for base_pml4. */
+static unsigned
+pml4_pcid (uint64_t *pml4) {
+	return pg_no (vtop (pml4)) % (PCID_CNT - 1) + 1;
+}
+
+/* Returns true if PML4 is the active page map. */
+static bool
+pml4_is_active (uint64_t *pml4) {
+	return PTE_ADDR (rcr3 ()) == vtop (pml4);
+}
+
 /* Loads page directory PD into the CPU's page directory base
- * register. */
+ * register.  With PCIDs, the TLB entries of PML4 survive from
+ * the last time it was active, unless they had to be dropped. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	uint64_t *target = pml4 ? pml4 : base_pml4;
+
+	cr3_load_cnt++;
+	if (!pcid_enabled) {
+		cr3_flush_cnt++;
+		lcr3 (vtop (target));
+		return;
+	}
+
+	unsigned pcid = pml4 ? pml4_pcid (pml4) : 0;
+	enum intr_level old_level = intr_disable ();
+	if (pcid_owner[pcid] == target)
+		lcr3 (vtop (target) | pcid | CR3_NOFLUSH);
+	else {
+		pcid_owner[pcid] = target;
+		cr3_flush_cnt++;
+		lcr3 (vtop (target) | pcid);
+	}
+	intr_set_level (old_level);
+}
+
+/* Removes any TLB entry for VA in PML4.  If PML4 is not active,
+ * its PCID may still hold entries; INVPCID drops the one for VA,
+ * and without it the PCID is disowned so that the next
+ * pml4_activate() flushes it. */
+static void
+pml4_invalidate (uint64_t *pml4, const void *va) {
+	if (pml4_is_active (pml4))
+		invlpg ((uint64_t) va);
+	else if (pcid_enabled) {
+		unsigned pcid = pml4_pcid (pml4);
+		if (pcid_owner[pcid] != pml4)
+			return;
+		if (invpcid_enabled)
+			invpcid (0, pcid, (uint64_t) va);
+		else
+			pcid_owner[pcid] = NULL;
+	}
+}
+
+/* Prints paging statistics. */
+void
+mmu_print_stats (void) {
+	printf ("Paging: PCID %s, %lld CR3 loads, %lld TLB flushes\n",
+			pcid_enabled ? (invpcid_enabled ? "on (INVPCID)" : "on") : "off",
+			cr3_load_cnt, cr3_flush_cnt);
+	printf ("Page tables: %lld cached, %lld zeroed on demand, %lld recycled, "
+			"%lld 2 MB pages split\n",
+			pt_hit_cnt, pt_miss_cnt, pt_recycle_cnt, pde_split_cnt);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -216,8 +536,11 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
-	if (pte && (*pte & PTE_P))
+	if (pte && (*pte & PTE_P)) {
+		if (is_huge_pte (pte))
+			return ptov (HUGE_PTE_ADDR (*pte)) + ((uint64_t) uaddr & HUGE_PGMASK);
 		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
+	}
 	return NULL;
 }
 
@@ -254,11 +577,95 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 	ASSERT (is_user_vaddr (upage));
 
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	if (pte != NULL && is_huge_pte (pte) && (*pte & PTE_P) != 0) {
+		/* Only UPAGE goes away; the rest of the 2 MB page stays
+		 * mapped.  If no page table can be had, drop it all. */
+		uint64_t *split = pml4e_walk (pml4, (uint64_t) upage, true);
+		if (split == NULL) {
+			pml4_clear_huge_page (pml4, pg_huge_round_down (upage));
+			return;
+		}
+		pte = split;
+	}
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		pml4_invalidate (pml4, upage);
+	}
+}
+
+/* Maps the 2 MB user virtual page UPAGE in PML4 to the physically
+ * contiguous frames starting at kernel virtual address KPAGE, with a
+ * single page directory entry.  Both must be 2 MB aligned; KPAGE
+ * normally comes from palloc_get_huge_page().  Nothing in the 2 MB
+ * range may be mapped yet; an empty page table left behind there is
+ * reclaimed.  Returns true if successful, false if memory
+ * allocation failed or part of the range is in use. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & HUGE_PGMASK) == 0);
+	ASSERT ((vtop (kpage) & HUGE_PGMASK) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t *pde = pml4_pde_walk (pml4, (uint64_t) upage, 1);
+	if (pde == NULL)
+		return false;
+
+	if (*pde & PTE_P) {
+		if (*pde & PTE_PS)
+			return false;
+
+		if (PTE_CNT (*pde) > 0)
+			return false;
+		uint64_t *pt = ptov (PTE_ADDR (*pde));
+		*pde = 0;
+		pml4_invalidate (pml4, upage);
+		pt_free (pt);
+	}
+
+	*pde = vtop (kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	return true;
+}
+
+/* Marks the 2 MB user virtual page UPAGE "not present" in PML4.
+ * The frames are not freed.  UPAGE need not be mapped by a 2 MB
+ * page; if it is not, nothing happens. */
+void
+pml4_clear_huge_page (uint64_t *pml4, void *upage) {
+	ASSERT (((uint64_t) upage & HUGE_PGMASK) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	uint64_t *pde = pml4_pde_walk (pml4, (uint64_t) upage, false);
+	if (pde != NULL && (*pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS)) {
+		*pde &= ~PTE_P;
+		pml4_invalidate (pml4, upage);
+	}
+}
+
+/* Returns true if user virtual address UADDR is mapped by a 2 MB
+ * page in PML4. */
+bool
+pml4_is_huge_page (uint64_t *pml4, const void *uaddr) {
+	uint64_t *pde = pml4_pde_walk (pml4, (uint64_t) uaddr, false);
+	return pde != NULL && (*pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS);
+}
+
+/* Sets the writable bit of the PTE for user virtual page UPAGE in
+ * PML4 to WRITABLE, keeping the rest of the entry, and flushes the
+ * stale translation.  Does nothing if UPAGE is not mapped. */
+void
+pml4_set_writable (uint64_t *pml4, void *upage, bool writable) {
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	if (pte != NULL && (*pte & PTE_P) != 0) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t) PTE_W;
+		pml4_invalidate (pml4, upage);
 	}
 }
 
@@ -277,14 +684,13 @@ pml4_is_dirty (uint64_t *pml4, const void *vpage) {
 void
 pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
-	if (pte) {
+	if (pte && *pte != 0) {
 		if (dirty)
 			*pte |= PTE_D;
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		pml4_invalidate (pml4, vpage);
 	}
 }
 
@@ -303,13 +709,12 @@ pml4_is_accessed (uint64_t *pml4, const void *vpage) {
 void
 pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
-	if (pte) {
+	if (pte && *pte != 0) {
 		if (accessed)
 			*pte |= PTE_A;
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		pml4_invalidate (pml4, vpage);
 	}
 }
@@ -8,7 +8,9 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/pte.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
@@ -24,15 +26,36 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool also keeps a short list of free pages that the idle
+   thread has already filled with zeros, so that PAL_ZERO requests
+   for a single page usually cost a list pop instead of a memset.
+   Pages on the list count as allocated in used_map; they are
+   handed out for any request once the pool runs out of other
+   pages. */
 
 /* A memory pool. */
 struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+
+	/* Pre-zeroed pages, linked through their first word.
+	   Protected by disabling interrupts, not by LOCK, so that the
+	   idle thread can add to it without risking a sleep. */
+	uint64_t *zero_list;
+	size_t zero_cnt;                /* Number of pages on zero_list. */
+
+	/* Statistics. */
+	long long zero_hit_cnt;         /* PAL_ZERO pages from zero_list. */
+	long long zero_miss_cnt;        /* PAL_ZERO pages zeroed on demand. */
+	long long zero_fill_cnt;        /* Pages zeroed by the idle thread. */
 };
 
+/* Number of pre-zeroed pages the idle thread keeps in each pool. */
+#define ZERO_HIGH 32
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
@@ -42,6 +65,10 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void *zero_list_pop (struct pool *);
+static void zero_list_push (struct pool *, void *page);
+static bool zero_list_drain (struct pool *);
+static size_t huge_scan_and_flip (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -258,24 +285,43 @@ palloc_init (void) {
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   FLAGS, in which case the kernel panics.  If PAL_NOWAIT is set
+   and the pool is busy, returns a null pointer at once; this lets
+   threads that must not sleep, like the idle thread, allocate. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	void *pages;
 
-	lock_acquire (&pool->lock);
+	if ((flags & PAL_ZERO) && page_cnt == 1
+			&& (pages = zero_list_pop (pool)) != NULL) {
+		pool->zero_hit_cnt++;
+		return pages;
+	}
+
+	if (flags & PAL_NOWAIT) {
+		if (!lock_try_acquire (&pool->lock))
+			return NULL;
+	} else
+		lock_acquire (&pool->lock);
 	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+	if (page_idx == BITMAP_ERROR && page_cnt > 1 && zero_list_drain (pool))
+		page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
 	lock_release (&pool->lock);
-	void *pages;
 
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
+	else if (page_cnt == 1 && (pages = zero_list_pop (pool)) != NULL)
+		return pages;
 	else
 		pages = NULL;
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if (flags & PAL_ZERO) {
 			memset (pages, 0, PGSIZE * page_cnt);
+			if (page_cnt == 1)
+				pool->zero_miss_cnt++;
+		}
 	} else {
 		if (flags & PAL_ASSERT)
 			PANIC ("palloc_get: out of pages");
@@ -296,6 +342,34 @@ palloc_get_page (enum palloc_flags flags) {
 	return palloc_get_multiple (flags, 1);
 }
 
+/* Obtains HUGE_PGCNT contiguous free pages whose physical address
+   is 2 MB aligned, suitable for mapping with a single 2 MB page
+   (see pml4_set_huge_page()), and returns the kernel virtual
+   address of the first.  FLAGS are as for palloc_get_multiple().
+   Free the result with palloc_free_multiple (pages, HUGE_PGCNT). */
+void *
+palloc_get_huge_page (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	void *pages = NULL;
+
+	lock_acquire (&pool->lock);
+	size_t page_idx = huge_scan_and_flip (pool);
+	if (page_idx == BITMAP_ERROR && zero_list_drain (pool))
+		page_idx = huge_scan_and_flip (pool);
+	lock_release (&pool->lock);
+
+	if (page_idx != BITMAP_ERROR) {
+		pages = pool->base + PGSIZE * page_idx;
+		if (flags & PAL_ZERO)
+			memset (pages, 0, HUGE_PGSIZE);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get_huge_page: out of pages");
+	}
+
+	return pages;
+}
+
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
@@ -328,6 +402,134 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the first page of the user pool and stores the number
+   of pages it spans in *PAGE_CNT.  Every page that
+   palloc_get_page (PAL_USER) can return lies in this range, so
+   callers may index per-page data by page number. */
+void *
+palloc_user_pool (size_t *page_cnt) {
+	*page_cnt = bitmap_size (user_pool.used_map);
+	return user_pool.base;
+}
+
+/* Zeroes one free page and adds it to a pool's list of pre-zeroed
+   pages, unless both lists are full.  Returns true if it did so.
+   Meant for the idle thread: it never sleeps, giving up instead
+   if a pool is busy. */
+bool
+palloc_zero_refill (void) {
+	struct pool *pools[] = { &kernel_pool, &user_pool };
+
+	for (size_t i = 0; i < sizeof pools / sizeof *pools; i++) {
+		struct pool *pool = pools[i];
+		if (pool->zero_cnt >= ZERO_HIGH || !lock_try_acquire (&pool->lock))
+			continue;
+		size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, 1, false);
+		lock_release (&pool->lock);
+		if (page_idx == BITMAP_ERROR)
+			continue;
+
+		void *page = pool->base + PGSIZE * page_idx;
+		memset (page, 0, PGSIZE);
+		zero_list_push (pool, page);
+		pool->zero_fill_cnt++;
+		return true;
+	}
+	return false;
+}
+
+/* Returns the number of pre-zeroed pages waiting in the pool
+   FLAGS selects.  They are marked used in the pool bitmap but are
+   free: any single-page allocation takes one once the bitmap runs
+   out, and multi-page allocations drain them back into it. */
+size_t
+palloc_zero_cnt (enum palloc_flags flags) {
+	return (flags & PAL_USER ? &user_pool : &kernel_pool)->zero_cnt;
+}
+
+/* Prints statistics about pre-zeroed pages. */
+void
+palloc_print_stats (void) {
+	printf ("Zeroed pages: kernel %lld hits, %lld misses; "
+			"user %lld hits, %lld misses; %lld zeroed while idle\n",
+			kernel_pool.zero_hit_cnt, kernel_pool.zero_miss_cnt,
+			user_pool.zero_hit_cnt, user_pool.zero_miss_cnt,
+			kernel_pool.zero_fill_cnt + user_pool.zero_fill_cnt);
+}
+
+/* Removes and returns a page from POOL's pre-zeroed pages, or
+   returns a null pointer if there are none. */
+static void *
+zero_list_pop (struct pool *pool) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t *page = pool->zero_list;
+	if (page != NULL) {
+		pool->zero_list = (uint64_t *) page[0];
+		pool->zero_cnt--;
+	}
+	intr_set_level (old_level);
+
+	if (page != NULL)
+		page[0] = 0;
+	return page;
+}
+
+/* Adds PAGE, which is allocated and filled with zeros, to POOL's
+   pre-zeroed pages. */
+static void
+zero_list_push (struct pool *pool, void *page_) {
+	uint64_t *page = page_;
+	enum intr_level old_level = intr_disable ();
+	page[0] = (uint64_t) pool->zero_list;
+	pool->zero_list = page;
+	pool->zero_cnt++;
+	intr_set_level (old_level);
+}
+
+/* Returns all of POOL's pre-zeroed pages to its free pages, so
+   that they can be part of a multi-page allocation.  POOL's lock
+   must be held.  Returns true if there were any. */
+static bool
+zero_list_drain (struct pool *pool) {
+	ASSERT (lock_held_by_current_thread (&pool->lock));
+
+	enum intr_level old_level = intr_disable ();
+	uint64_t *page = pool->zero_list;
+	pool->zero_list = NULL;
+	pool->zero_cnt = 0;
+	intr_set_level (old_level);
+
+	if (page == NULL)
+		return false;
+	while (page != NULL) {
+		uint64_t *next = (uint64_t *) page[0];
+		bitmap_reset (pool->used_map, pg_no (page) - pg_no (pool->base));
+		page = next;
+	}
+	return true;
+}
+
+/* Finds HUGE_PGCNT free pages in POOL whose physical address is
+   2 MB aligned, marks them used and returns the index of the
+   first, or BITMAP_ERROR if there are none.  POOL's lock must be
+   held.  Pages on the zero list count as used, so callers drain
+   it before giving up. */
+static size_t
+huge_scan_and_flip (struct pool *pool) {
+	size_t page_cnt = bitmap_size (pool->used_map);
+	size_t page_idx = (HUGE_PGSIZE - (vtop (pool->base) & HUGE_PGMASK))
+		% HUGE_PGSIZE / PGSIZE;
+
+	ASSERT (lock_held_by_current_thread (&pool->lock));
+
+	for (; page_idx + HUGE_PGCNT <= page_cnt; page_idx += HUGE_PGCNT)
+		if (bitmap_none (pool->used_map, page_idx, HUGE_PGCNT)) {
+			bitmap_set_multiple (pool->used_map, page_idx, HUGE_PGCNT, true);
+			return page_idx;
+		}
+	return BITMAP_ERROR;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
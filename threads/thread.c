@@ -7,6 +7,7 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -71,6 +72,7 @@ bool thread_mlfqs;
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
+static void idle_work(void);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
@@ -564,6 +566,14 @@ idle(void *idle_started_ UNUSED)
 		intr_disable();
 		thread_block();
 
+		/* Spend the idle time on background work, then sleep only
+		   if nobody became ready meanwhile. */
+		intr_enable();
+		idle_work();
+		intr_disable();
+		if (!list_empty(&ready_list))
+			continue;
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -580,6 +590,16 @@ idle(void *idle_started_ UNUSED)
 	}
 }
 
+/* Background work done by the idle thread, a step at a time, for
+   as long as no other thread is ready to run.  Every step must
+   finish without blocking. */
+static void
+idle_work(void)
+{
+	while (list_empty(&ready_list) && (pt_cache_refill() || palloc_zero_refill()))
+		continue;
+}
+
 /* Function used as the basis for a kernel thread. */
 static void
 kernel_thread(thread_func *function, void *aux)
@@ -933,6 +953,15 @@ void thread_all_calc_priority()
 	}
 }
 
+/* 모든 쓰레드에 FUNC를 호출하며 AUX를 넘겨줌 - 인터럽트를 끈 상태에서 호출해야 함 */
+void thread_foreach(thread_action_func *func, void *aux)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+		func(list_entry(e, struct thread, all_elem), aux);
+}
+
 /* NOTE: [1.3/Improve] `모든` 쓰레드의 recent_cpu를 재계산하는 함수 구현 */
 void thread_all_calc_recent_cpu()
 {
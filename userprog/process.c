@@ -28,12 +28,15 @@
 
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/vma.h"
 #endif
 
 static void process_cleanup(void);
 static bool load(const char *file_name, struct intr_frame *if_);
 static void initd(void *f_name);
 static void __do_fork(void *);
+static void __do_spawn(void *);
+static bool process_load(void *f_name, struct intr_frame *if_);
 static void argument_stack(char **parse, int count, void **rsp);
 
 /* General process initializer for initd and other process. */
@@ -172,6 +175,10 @@ __do_fork(void *aux)
 		goto error;
 
 	process_activate(current);
+	/* NOTE: [2.5] 자식도 실행 파일을 따로 열어 둠 - 부모가 먼저 종료해도 쓰기 금지가 풀리지 않고,
+	 * 자식의 text / data 페이지는 부모가 닫는 run_file 대신 이 파일에서 다시 읽는다. */
+	if (parent->run_file != NULL && (current->run_file = file_duplicate(parent->run_file)) == NULL)
+		goto error;
 #ifdef VM
 	supplemental_page_table_init(&current->spt);
 	if (!supplemental_page_table_copy(&current->spt, &parent->spt))
@@ -200,6 +207,72 @@ error:
 	exit(TID_ERROR);
 }
 
+/* NOTE: [spawn] 부모가 자식의 로드 결과를 기다리는 데 쓰는 정보 - 부모의 스택에 있음 */
+struct spawn_info
+{
+	char *cmd_line;			 /* 실행할 명령줄 (palloc 페이지, 자식이 해제) */
+	struct semaphore loaded; /* 자식이 로드를 마치면 up */
+	bool success;			 /* 로드 성공 여부 */
+};
+
+/**
+ * @brief CMD_LINE의 프로그램을 실행하는 자식 프로세스를 만드는 함수 - fork 후 바로 exec하는 것과 같다.
+ * 부모의 주소 공간과 파일 디스크립터 테이블을 복사하지 않고, 자식은 빈 주소 공간에 바로 프로그램을 로드한다.
+ * 부모는 자식이 로드를 마칠 때까지만 기다린다.
+ *
+ * @param cmd_line 실행할 명령줄 (palloc 페이지 - 이 함수가 소유)
+ * @return tid_t 자식의 tid, 스레드를 만들지 못했거나 로드에 실패하면 TID_ERROR
+ */
+tid_t process_spawn(char *cmd_line)
+{
+	struct spawn_info info;
+	char name[16], *save_ptr;
+
+	/* 스레드 이름은 프로그램 이름 */
+	strlcpy(name, cmd_line, sizeof name);
+	strtok_r(name, " ", &save_ptr);
+
+	info.cmd_line = cmd_line;
+	sema_init(&info.loaded, 0);
+	tid_t tid = thread_create(name, PRI_DEFAULT, __do_spawn, &info);
+	if (tid == TID_ERROR)
+	{
+		palloc_free_page(cmd_line);
+		return TID_ERROR;
+	}
+	sema_down(&info.loaded);
+	if (!info.success)
+	{
+		/* 로드에 실패한 자식은 바로 종료하므로 여기서 거둠 */
+		process_wait(tid);
+		return TID_ERROR;
+	}
+	return tid;
+}
+
+/* spawn으로 만든 자식 스레드가 실행하는 함수 - 프로그램을 로드하고 결과를 부모에게 알린 뒤 유저 모드로 전환 */
+static void
+__do_spawn(void *aux)
+{
+	struct spawn_info *info = aux;
+	struct intr_frame if_;
+
+#ifdef VM
+	supplemental_page_table_init(&thread_current()->spt);
+#endif
+	process_init();
+
+	/* info는 sema_up 이후 사라지므로 먼저 결과를 기록 */
+	info->success = process_load(info->cmd_line, &if_);
+	bool success = info->success;
+	sema_up(&info->loaded);
+	if (!success)
+		exit(-1);
+
+	do_iret(&if_);
+	NOT_REACHED();
+}
+
 /**
  * @brief 현재 실행 컨텍스트를 f_name이 가리키는 프로세스로 전환하는 함수
  *
@@ -207,6 +280,29 @@ error:
  * @return int 실패 시 -1 반환
  */
 int process_exec(void *f_name) /* NOTE: 강의의 start_process() */
+{
+	/* We cannot use the intr_frame in the thread structure.
+	 * This is because when current thread rescheduled,
+	 * it stores the execution information to the member. */
+	struct intr_frame _if;
+
+	if (!process_load(f_name, &_if))
+		return -1;
+
+	/* Start switched process. */
+	do_iret(&_if);
+	NOT_REACHED();
+}
+
+/**
+ * @brief 현재 주소 공간을 지우고 f_name의 프로그램을 로드하는 함수 - 인자를 스택에 넣은 유저 컨텍스트를 IF_에 채운다.
+ *
+ * @param f_name 실행할 프로세스의 이름 (파싱 안 된 값, palloc 페이지 - 이 함수가 해제)
+ * @param if_ 프로그램을 시작할 유저 컨텍스트
+ * @return false 로드 실패
+ */
+static bool
+process_load(void *f_name, struct intr_frame *if_)
 {
 	char *token, *saveptr;
 	char *file_name = strtok_r(f_name, " ", &saveptr);
@@ -222,39 +318,39 @@ int process_exec(void *f_name) /* NOTE: 강의의 start_process() */
 		count++;
 	}
 
-	/* We cannot use the intr_frame in the thread structure.
-	 * This is because when current thread rescheduled,
-	 * it stores the execution information to the member. */
-	struct intr_frame _if;
-	_if.ds = _if.es = _if.ss = SEL_UDSEG;
-	_if.cs = SEL_UCSEG;
-	_if.eflags = FLAG_IF | FLAG_MBS;
+	if_->ds = if_->es = if_->ss = SEL_UDSEG;
+	if_->cs = SEL_UCSEG;
+	if_->eflags = FLAG_IF | FLAG_MBS;
 
 	/* We first kill the current context */
 	process_cleanup();
 
 	lock_acquire(&filesys_lock);
-	/* And then load the binary */
-	success = load(file_name, &_if);
+	/* NOTE: [2.5] 이전 실행 파일에서 읽을 페이지가 없어졌으므로 닫아 쓰기 금지를 풂 */
+	file_close(thread_current()->run_file);
+	thread_current()->run_file = NULL;
 	lock_release(&filesys_lock);
+	/* And then load the binary */
+	success = load(file_name, if_);
 
 	/* If load failed, quit. */
 	palloc_free_page(f_name);
 	if (!success)
 	{
 		free(parse);
-		return -1;
+		return false;
 	}
+#ifdef VM
+	/* NOTE: [VM] exec 당 폴트 수 통계 */
+	vm_exec_loaded();
+#endif
 
 	/* NOTE: [2.1] 스택에 인자 push 후 dump로 출력 */
-	argument_stack(parse, count, &_if.rsp);
+	argument_stack(parse, count, &if_->rsp);
 	free(parse);
-	_if.R.rsi = _if.rsp + sizeof(void (*)());
-	_if.R.rdi = count;
-
-	/* Start switched process. */
-	do_iret(&_if);
-	NOT_REACHED();
+	if_->R.rsi = if_->rsp + sizeof(void (*)());
+	if_->R.rdi = count;
+	return true;
 }
 
 /**
@@ -522,6 +618,8 @@ load(const char *file_name, struct intr_frame *if_)
 		goto done;
 	process_activate(thread_current());
 
+	/* NOTE: [VM] 실행 파일을 읽는 동안만 filesys_lock을 잡음 - 스택을 올릴 때는 VM 락을 잡으므로 먼저 놓는다. */
+	lock_acquire(&filesys_lock);
 	/* Open executable file. */
 	file = filesys_open(file_name);
 	if (file == NULL)
@@ -598,6 +696,7 @@ load(const char *file_name, struct intr_frame *if_)
 	/* NOTE: [2.5] 파일 open 시 file_deny_write() 호출 / thread 구조체에 실행 중인 파일 추가 */
 	file_deny_write(file);
 	t->run_file = file;
+	lock_release(&filesys_lock);
 
 	/* Set up stack. */
 	if (!setup_stack(if_))
@@ -611,6 +710,8 @@ load(const char *file_name, struct intr_frame *if_)
 done:
 	/* We arrive here whether the load is successful or not. */
 	// file_close(file);
+	if (lock_held_by_current_thread(&filesys_lock))
+		lock_release(&filesys_lock);
 	return success;
 }
 
@@ -794,7 +895,6 @@ bool lazy_load_segment(struct page *page, void *aux)
 	file_seek(file, offset);
 	if (file_read(file, page->frame->kva, read_bytes) != (off_t)read_bytes)
 	{
-		palloc_free_page(page->frame->kva);
 		if (flag)
 			lock_release(&filesys_lock);
 		return false;
@@ -827,38 +927,13 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT(pg_ofs(upage) == 0);
 	ASSERT(ofs % PGSIZE == 0);
 
+	size_t length = read_bytes + zero_bytes;
 	read_bytes = file_length(file) < read_bytes ? file_length(file) : read_bytes;
-	while (read_bytes > 0 || zero_bytes > 0)
-	{
-		/* Do calculate how to fill this page.
-		 * We will read PAGE_READ_BYTES bytes from FILE
-		 * and zero the final PAGE_ZERO_BYTES bytes. */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		/* NOTE: [VM] `aux` 인수로 제공할 보조 값 설정하기 */
-		/* NOTE: [VM] 바이너리를 로드하는 데 필요한 정보를 포함하는 구조체를 생성하는 것이 좋다. */
-		/* NOTE: Set up aux to pass information to the lazy_load_segment. */
-		struct page_load_info *page_load_info = malloc(sizeof(struct page_load_info));
-		page_load_info->file = file;
-		page_load_info->offset = ofs;
-		page_load_info->read_bytes = page_read_bytes;
-		page_load_info->zero_bytes = page_zero_bytes;
-
-		if (!vm_alloc_page_with_initializer(VM_ANON, upage,
-											writable, lazy_load_segment, (void *)page_load_info))
-		{
-			free(page_load_info);
-			return false;
-		}
 
-		/* Advance. */
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		upage += PGSIZE;
-		ofs += page_read_bytes; /* offset 업데이트 */
-	}
-	return true;
+	/* NOTE: [VM] segment 하나를 구간 하나로 등록 - 페이지 구조체는 lazy_load_segment로 채울 첫 폴트 때 만든다. */
+	/* NOTE: [VM] 읽기 전용 segment는 다른 프로세스와 frame을 공유하는 text 페이지 */
+	return vma_map(&thread_current()->spt, upage, length, writable ? VM_ANON : VM_ANON | VM_TEXT,
+				   writable, file, ofs, read_bytes);
 }
 
 /**
@@ -891,9 +966,15 @@ setup_stack(struct intr_frame *if_)
 	/* 스택은 아래로 확장되기 때문에 USER_STACK보다 PGSIZE만큼 낮은 주소에 페이지를 할당해야 한다. */
 	void *stack_bottom = (void *)(((uint8_t *)USER_STACK) - PGSIZE);
 
+	/* NOTE: [VM] 스택 페이지도 쓰기 가능한 anon 메모리로 예약 */
+	if (!vm_commit(&thread_current()->spt, 1))
+		return false;
 	/* anonymous 페이지 할당 받기, VM_MARKER_0는 이 페이지가 스택임을 구분하기 위한 마커 */
 	if (!vm_alloc_page(VM_ANON | VM_MARKER_0, stack_bottom, true))
+	{
+		vm_uncommit(&thread_current()->spt, 1);
 		return false;
+	}
 
 	/* 할당 받은 페이지를 프레임과 매핑 */
 	if (!vm_claim_page(stack_bottom))
@@ -10,11 +10,16 @@
 /* NOTE: [2.2] 구현에 필요한 라이브러리 include */
 #include "threads/init.h"
 #include "filesys/filesys.h"
+#include "filesys/directory.h"
 #include "lib/string.h"
 #include "lib/syscall-nr.h"
 #include "userprog/process.h"
 #include "devices/input.h"
 #include "threads/palloc.h"
+#ifdef VM
+#include "vm/vma.h"
+#include "vm/shm.h"
+#endif
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
@@ -36,11 +41,15 @@ void syscall_handler(struct intr_frame *);
 #define USER_AREA_STAR 0x8048000
 #define USER_AREA_END 0xc0000000
 
+/* NOTE: [VM] read/write가 사용자 버퍼와 파일 사이에서 한 번에 옮기는 바이트 수
+ * 사용자 버퍼에서 폴트가 나면 VM 락을 잡으므로 filesys_lock을 잡은 채 접근하지 않고 커널 버퍼를 거친다. */
+#define IO_CHUNK 512
+
 /* process */
 void halt(void);
-void exit(int status);
 pid_t sys_fork(const char *thread_name, struct intr_frame *f);
 pid_t exec(const char *cmd_line);
+pid_t spawn(const char *cmd_line);
 
 /* file */
 int wait(pid_t pid);
@@ -57,8 +66,14 @@ void close(int fd);
 /* vm */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
+int madvise(void *addr, size_t length, int advice);
+int msync(void *addr, size_t length, int flags);
+int meminfo(pid_t pid, struct meminfo *info);
+void *shm_map(const char *name, size_t size, void *addr);
+int shm_unlink(const char *name);
 
 void check_address(void *addr);
+static bool copy_file_name(const char *file, char kname[NAME_MAX + 1]);
 
 void syscall_init(void)
 {
@@ -83,6 +98,9 @@ void syscall_handler(struct intr_frame *f)
 	uint64_t syscall_num = f->R.rax;
 #ifdef VM
 	thread_current()->user_rsp = f->rsp;
+	/* NOTE: [VM] OOM killer가 고른 프로세스는 시스템 콜을 처리하지 않고 종료 */
+	if (thread_current()->oom_killed)
+		exit(-1);
 #endif
 
 	switch (syscall_num)
@@ -99,6 +117,9 @@ void syscall_handler(struct intr_frame *f)
 	case SYS_EXEC: // 3
 		f->R.rax = exec(f->R.rdi);
 		break;
+	case SYS_SPAWN:
+		f->R.rax = spawn(f->R.rdi);
+		break;
 	case SYS_WAIT: // 4
 		f->R.rax = wait(f->R.rdi);
 		break;
@@ -135,6 +156,21 @@ void syscall_handler(struct intr_frame *f)
 	case SYS_MUNMAP: // 15
 		munmap(f->R.rdi);
 		break;
+	case SYS_MADVISE:
+		f->R.rax = madvise(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_MSYNC:
+		f->R.rax = msync(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_MEMINFO:
+		f->R.rax = meminfo(f->R.rdi, f->R.rsi);
+		break;
+	case SYS_SHM_MAP:
+		f->R.rax = shm_map(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_SHM_UNLINK:
+		f->R.rax = shm_unlink(f->R.rdi);
+		break;
 	}
 }
 
@@ -181,6 +217,19 @@ pid_t exec(const char *cmd_line)
 		exit(-1);
 }
 
+/* NOTE: [spawn] fork 후 바로 exec하는 것과 같은 자식을 주소 공간 복사 없이 만드는 시스템 콜 - 자식의 pid, 실패하면 -1 */
+pid_t spawn(const char *cmd_line)
+{
+	check_address(cmd_line);
+
+	char *cmd_line_cpy = palloc_get_page(0);
+	if (cmd_line_cpy == NULL)
+		return TID_ERROR;
+	strlcpy(cmd_line_cpy, cmd_line, PGSIZE);
+
+	return process_spawn(cmd_line_cpy);
+}
+
 /* NOTE: [2.3] wait() 시스템 콜 구현 */
 int wait(pid_t pid)
 {
@@ -192,12 +241,15 @@ int wait(pid_t pid)
 /* NOTE: [2.2] 파일을 생성하는 시스템 콜*/
 bool create(const char *file, unsigned initial_size)
 {
-	check_address(file);
+	char kname[NAME_MAX + 1];
+
+	if (!copy_file_name(file, kname))
+		return false;
 
 	bool success;
 	lock_acquire(&filesys_lock);
 	/* 파일 이름과 크기에 해당하는 파일 생성*/
-	success = filesys_create(file, initial_size);
+	success = filesys_create(kname, initial_size);
 	lock_release(&filesys_lock);
 	/* 파일 생성 성공 시 true 반환, 실패 시 false 반환 */
 	return success;
@@ -206,12 +258,15 @@ bool create(const char *file, unsigned initial_size)
 /* NOTE: [2.2] 파일을 삭제하는 시스템 콜 */
 bool remove(const char *file)
 {
-	check_address(file);
+	char kname[NAME_MAX + 1];
+
+	if (!copy_file_name(file, kname))
+		return false;
 
 	bool success;
 	lock_acquire(&filesys_lock);
 	/* 파일 이름에 해당하는 파일을 제거*/
-	success = filesys_remove(file);
+	success = filesys_remove(kname);
 	lock_release(&filesys_lock);
 	/* 파일 제거 성공 시 true 반환, 실패 시 false 반환 */
 	return success;
@@ -220,11 +275,14 @@ bool remove(const char *file)
 /* NOTE: [2.4] open() 시스템 콜 구현 */
 int open(const char *file_name)
 {
-	check_address(file_name);
+	char kname[NAME_MAX + 1];
+
+	if (!copy_file_name(file_name, kname))
+		return -1;
 	lock_acquire(&filesys_lock);
 	/* 파일을 open */
 	int fd = -1;
-	struct file *file = filesys_open(file_name);
+	struct file *file = filesys_open(kname);
 
 	/* 해당 파일 객체에 파일 디스크립터 부여*/
 	/* 파일 디스크립터 리턴*/
@@ -259,32 +317,45 @@ int read(int fd, void *buffer, unsigned size)
 {
 	check_address(buffer);
 #ifdef VM
-	// NOTE: [VM] buffer가 들어있는 프레임이 쓰기 가능한지 확인
-	struct page *page = spt_find_page(&thread_current()->spt, buffer);
-	if (page && !page->writable)
+	// NOTE: [VM] buffer가 들어있는 프레임이 쓰기 가능한지 확인 - 아직 페이지가 없으면 구간을 확인
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct page *page = spt_find_page(spt, buffer);
+	struct vma *vma = page == NULL ? vma_find(spt, buffer) : NULL;
+	if ((page && !page->writable) || (vma && !vma->writable))
 		exit(-1);
 #endif
-	/* 파일에 동시 접근이 일어날 수 있으므로 Lock 사용 */
-	lock_acquire(&filesys_lock);
-	/* 파일 디스크립터를 이용하여 파일 객체 검색 */
-	struct file *file = process_get_file(fd);
 	/* 파일 디스크립터가 0일 경우 키보드에 입력을 버퍼에 저장 후 버퍼의 저장한 크기를 리턴 (input_getc() 이용) */
 	if (fd == 0)
 	{
 		uint8_t user_input = input_getc();
 		memcpy(buffer, &user_input, sizeof(user_input));
-		lock_release(&filesys_lock);
 		return sizeof(user_input);
 	}
-	/* 파일 디스크립터가 0이 아닐 경우 파일의 데이터를 크기만큼 저장 후 읽은 바이트 수를 리턴 */
-	if (fd >= 2 && file)
+
+	/* 파일에 동시 접근이 일어날 수 있으므로 Lock 사용 */
+	lock_acquire(&filesys_lock);
+	/* 파일 디스크립터를 이용하여 파일 객체 검색 */
+	struct file *file = fd >= 2 ? process_get_file(fd) : NULL;
+	lock_release(&filesys_lock);
+	if (file == NULL)
+		return -1;
+
+	/* 파일 디스크립터가 0이 아닐 경우 파일의 데이터를 크기만큼 저장 후 읽은 바이트 수를 리턴
+	 * NOTE: [VM] 커널 버퍼에 읽고 락을 놓은 뒤 사용자 버퍼에 복사 */
+	uint8_t kbuf[IO_CHUNK];
+	unsigned bytes = 0;
+	while (bytes < size)
 	{
-		int bytes = file_read(file, buffer, size);
+		off_t chunk = size - bytes < IO_CHUNK ? size - bytes : IO_CHUNK;
+		lock_acquire(&filesys_lock);
+		off_t n = file_read(file, kbuf, chunk);
 		lock_release(&filesys_lock);
-		return bytes;
+		memcpy((uint8_t *)buffer + bytes, kbuf, n);
+		bytes += n;
+		if (n < chunk)
+			break;
 	}
-	lock_release(&filesys_lock);
-	return -1;
+	return bytes;
 }
 
 /* NOTE: [2.4] write() 시스템 콜 구현 */
@@ -295,23 +366,34 @@ int write(int fd, const void *buffer, unsigned size)
 	/* 파일에 동시 접근이 일어날 수 있으므로 Lock 사용 */
 	lock_acquire(&filesys_lock);
 	/* 파일 디스크립터를 이용하여 파일 객체 검색 */
-	struct file *file = process_get_file(fd);
-	/* 파일 디스크립터가 1일 경우 버퍼에 저장된 값을 화면에 출력 후 버퍼의 크기 리턴 (putbuf() 이용) */
-	if (fd == 1)
-	{
-		putbuf(buffer, size);
-		lock_release(&filesys_lock);
-		return sizeof(buffer);
-	}
-	/* 파일 디스크립터가 1이 아닐 경우 버퍼에 저장된 데이터를 크기만큼 파일에 기록 후 기록한 바이트 수를 리턴 */
-	if (fd >= 2 && file)
+	struct file *file = fd >= 2 ? process_get_file(fd) : NULL;
+	lock_release(&filesys_lock);
+	if (fd != 1 && file == NULL)
+		return -1;
+
+	/* 파일 디스크립터가 1일 경우 버퍼에 저장된 값을 화면에 출력 후 버퍼의 크기 리턴 (putbuf() 이용)
+	 * 1이 아닐 경우 버퍼에 저장된 데이터를 크기만큼 파일에 기록 후 기록한 바이트 수를 리턴
+	 * NOTE: [VM] 사용자 버퍼를 커널 버퍼에 복사한 뒤 락을 잡고 씀 */
+	uint8_t kbuf[IO_CHUNK];
+	unsigned bytes = 0;
+	while (bytes < size)
 	{
-		int bytes = file_write(file, buffer, size);
+		off_t chunk = size - bytes < IO_CHUNK ? size - bytes : IO_CHUNK;
+		memcpy(kbuf, (const uint8_t *)buffer + bytes, chunk);
+		if (fd == 1)
+		{
+			putbuf((const char *)kbuf, chunk);
+			bytes += chunk;
+			continue;
+		}
+		lock_acquire(&filesys_lock);
+		off_t n = file_write(file, kbuf, chunk);
 		lock_release(&filesys_lock);
-		return bytes;
+		bytes += n;
+		if (n < chunk)
+			break;
 	}
-	lock_release(&filesys_lock);
-	return -1;
+	return fd == 1 ? sizeof(buffer) : bytes;
 }
 
 /* NOTE: [2.4] seek() 시스템 콜 구현 */
@@ -366,6 +448,9 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 		return NULL;
 	if (spt_find_page(&thread_current()->spt, addr))
 		return NULL;
+	/* NOTE: [VM] 실행 파일의 segment나 다른 매핑과 겹치는지는 구간으로 확인 */
+	if (vma_overlaps(&thread_current()->spt, addr, addr + length))
+		return NULL;
 
 	struct file *file = process_get_file(fd);
 	if (!file)
@@ -382,7 +467,101 @@ void munmap(void *addr)
 	do_munmap(addr);
 }
 
+/* NOTE: [VM] 메모리 범위를 어떻게 쓸지 VM에 알려 주는 시스템 콜 - 성공하면 0, 실패하면 -1 */
+int madvise(void *addr, size_t length, int advice)
+{
+	if (addr == NULL || is_kernel_vaddr(addr) || addr != pg_round_down(addr))
+		return -1;
+	if (length == 0)
+		return 0;
+	if ((uint8_t *)addr + length < (uint8_t *)addr || is_kernel_vaddr((uint8_t *)addr + length - 1))
+		return -1;
+
+	return vm_madvise(addr, length, advice);
+}
+
+/* NOTE: [VM] 파일 매핑의 변경된 페이지를 파일에 쓰는 시스템 콜 - 성공하면 0, 실패하면 -1 */
+int msync(void *addr, size_t length, int flags)
+{
+	if (addr == NULL || is_kernel_vaddr(addr) || addr != pg_round_down(addr))
+		return -1;
+	if ((flags & ~(MS_ASYNC | MS_INVALIDATE | MS_SYNC)) || (flags & MS_ASYNC && flags & MS_SYNC))
+		return -1;
+	if (length == 0)
+		return 0;
+	if ((uint8_t *)addr + length < (uint8_t *)addr || is_kernel_vaddr((uint8_t *)addr + length - 1))
+		return -1;
+
+	return do_msync(addr, length, flags);
+}
+
+/* NOTE: [VM] 프로세스의 메모리 사용량을 알려 주는 시스템 콜 - 성공하면 0, 프로세스가 없으면 -1 */
+int meminfo(pid_t pid, struct meminfo *info)
+{
+	struct meminfo copy;
+
+	check_address(info);
+	check_address((uint8_t *)info + sizeof *info - 1);
+	if (!vm_meminfo(pid, &copy))
+		return -1;
+	/* 카운터를 모은 뒤 복사 - info에 폴트가 나도 카운터가 어긋나지 않음 */
+	*info = copy;
+	return 0;
+}
+
+/* NOTE: [VM] 사용자 공간의 세그먼트 이름을 커널 버퍼에 복사 - 이름이 너무 길면 false */
+static bool
+shm_copy_name(const char *name, char kname[SHM_NAME_MAX + 1])
+{
+	check_address(name);
+	if (strnlen(name, SHM_NAME_MAX + 1) > SHM_NAME_MAX)
+		return false;
+	strlcpy(kname, name, SHM_NAME_MAX + 1);
+	return true;
+}
+
+/* NOTE: [VM] 이름이 NAME인 공유 메모리 세그먼트를 ADDR에 매핑하는 시스템 콜 - 없으면 SIZE 바이트로 만듦 */
+void *shm_map(const char *name, size_t size, void *addr)
+{
+	char kname[SHM_NAME_MAX + 1];
+
+	if (!shm_copy_name(name, kname))
+		return NULL;
+	if (addr == NULL || is_kernel_vaddr(addr) || addr != pg_round_down(addr) || size == 0)
+		return NULL;
+	if ((uint8_t *)addr + size < (uint8_t *)addr || is_kernel_vaddr((uint8_t *)addr + size - 1))
+		return NULL;
+	if (spt_find_page(&thread_current()->spt, addr))
+		return NULL;
+	if (vma_overlaps(&thread_current()->spt, addr, (uint8_t *)addr + size))
+		return NULL;
+
+	return do_shm_map(kname, size, addr);
+}
+
+/* NOTE: [VM] 공유 메모리 세그먼트의 이름을 지우는 시스템 콜 - 성공하면 0, 그런 이름이 없으면 -1 */
+int shm_unlink(const char *name)
+{
+	char kname[SHM_NAME_MAX + 1];
+
+	if (!shm_copy_name(name, kname))
+		return -1;
+	return do_shm_unlink(kname);
+}
+
 /* ---------- UTIL ---------- */
+/* NOTE: [VM] 사용자 공간의 파일 이름을 커널 버퍼에 복사 - 이름이 너무 길면 false
+ * filesys_lock을 잡은 채 사용자 메모리에서 폴트가 나지 않도록 락을 잡기 전에 복사한다. */
+static bool
+copy_file_name(const char *file, char kname[NAME_MAX + 1])
+{
+	check_address(file);
+	if (strnlen(file, NAME_MAX + 1) > NAME_MAX)
+		return false;
+	strlcpy(kname, file, NAME_MAX + 1);
+	return true;
+}
+
 /* NOTE: [2.2] 추가 함수 - 주소 값이 유저 영역에서 사용하는 주소 값인지 확인하는 함수 */
 void check_address(void *addr)
 {
@@ -1,18 +1,83 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
+#include <stdio.h>
+#include <string.h>
+#include <syscall-nr.h>
 #include "vm/vm.h"
 #include "devices/disk.h"
 #include "threads/mmu.h"
 #include "lib/kernel/list.h"
+#include "threads/malloc.h"
+#include "userprog/process.h"
+#include "threads/palloc.h"
+#include "vm/shm.h"
+#include "vm/zswap.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
 static bool anon_swap_in(struct page *page, void *kva);
 static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
+static void anon_set_slot(struct page *page, size_t idx);
 
-/* TODO: swap table 만들기~~ */
-struct bitmap *swap_table;
+/* NOTE: [VM] 스왑 슬롯 하나는 한 페이지(8 섹터) 크기 */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+/* NOTE: [VM] 스왑 슬롯 할당 실패 */
+#define SWAP_ERROR SIZE_MAX
+
+/* NOTE: [VM] swap table - 비어 있는 연속 슬롯 구간(extent)의 목록
+ * 할당은 커서가 가리키는 구간부터 next-fit으로, 해제는 양옆 구간과 병합한다.
+ * 구간은 시작 슬롯과 끝 슬롯(다음 슬롯)으로 hash에서 바로 찾는다. */
+struct swap_extent
+{
+	size_t start;				 /* 첫 슬롯 */
+	size_t cnt;					 /* 슬롯 수 */
+	struct list_elem elem;		 /* swap_extents에 넣을 elem */
+	struct hash_elem start_elem; /* start로 찾기 */
+	struct hash_elem end_elem;	 /* start + cnt로 찾기 */
+};
+
+static struct list swap_extents;
+static struct list_elem *swap_cursor; /* 다음 할당을 시작할 구간 */
+static struct hash extent_by_start, extent_by_end;
+static size_t swap_slot_cnt, swap_free_cnt;
+
+static long long slot_alloc_cnt; /* 할당한 슬롯 수 */
+static long long slot_free_cnt;	 /* 해제한 슬롯 수 */
+static long long slot_fail_cnt;	 /* 스왑이 가득 차 실패한 할당 수 */
+static long long slot_scan_cnt;	 /* 할당 중 살펴본 구간 수 */
+
+static uint64_t extent_start_hash(const struct hash_elem *e, void *aux);
+static bool extent_start_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+static uint64_t extent_end_hash(const struct hash_elem *e, void *aux);
+static bool extent_end_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+static struct swap_extent *extent_new(size_t start, size_t cnt);
+
+/* NOTE: [VM] COW - 슬롯을 공유하는 페이지 수. 0이 되면 슬롯을 해제 */
+static uint16_t *swap_refs;
+
+/* NOTE: [VM] 한 번에 연속된 슬롯으로 내보내는 최대 페이지 수 (= readahead 창의 최대 크기) */
+#define SWAP_CLUSTER 8
+
+static size_t ra_window = 4;   /* readahead 창 - 폴트난 페이지를 포함해 읽을 페이지 수 */
+static struct thread *ra_last; /* 마지막으로 readahead한 프로세스 */
+static void *ra_next_va;	   /* 그 readahead가 끝난 바로 다음 주소 */
+
+static long long swap_out_cnt;	   /* 스왑에 쓴 페이지 수 */
+static long long swap_cluster_cnt; /* 클러스터(연속 쓰기) 수 */
+static long long swap_in_cnt;	   /* 폴트로 스왑에서 읽은 페이지 수 */
+static long long ra_cnt;		   /* 미리 읽은 페이지 수 */
+static long long ra_used_cnt;	   /* 미리 읽은 뒤 실제로 쓰인 페이지 수 */
+static long long disk_out_cnt;	   /* 스왑 디스크에 쓴 페이지 수 */
+static long long disk_in_cnt;	   /* 스왑 디스크에서 읽은 페이지 수 */
+static long long zero_out_cnt;	   /* 모두 0이라 스왑에 쓰지 않고 내보낸 페이지 수 */
+
+/* NOTE: [VM] 압축 스왑 캐시로 쓸 수 있는 최대 페이지 수 - user pool의 1/8 */
+#define ZSWAP_POOL_RATIO 8
+
+static void swap_disk_write(size_t slot, const void *page);
+static bool page_is_zero(const void *kva);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -31,7 +96,317 @@ void vm_anon_init(void)
 	 */
 	/* TODO: Set up the swap_disk. */
 	swap_disk = disk_get(1, 1);
-	swap_table = bitmap_create(disk_size(swap_disk));
+	/* NOTE: [VM] 스왑 슬롯(한 페이지) 단위로 관리 - 처음에는 전체가 하나의 빈 구간 */
+	swap_slot_cnt = swap_disk != NULL ? disk_size(swap_disk) / SECTORS_PER_SLOT : 0;
+	swap_refs = calloc(swap_slot_cnt + 1, sizeof *swap_refs);
+	if (swap_refs == NULL)
+		PANIC("swap table allocation failed");
+
+	list_init(&swap_extents);
+	hash_init(&extent_by_start, extent_start_hash, extent_start_less, NULL);
+	hash_init(&extent_by_end, extent_end_hash, extent_end_less, NULL);
+	if (swap_slot_cnt > 0 && extent_new(0, swap_slot_cnt) == NULL)
+		PANIC("swap table allocation failed");
+	swap_cursor = list_begin(&swap_extents);
+	swap_free_cnt = swap_slot_cnt;
+
+	/* NOTE: [VM] 스왑 디스크 앞에 압축 캐시를 둠 */
+	size_t user_pages;
+	palloc_user_pool(&user_pages);
+	zswap_init(swap_slot_cnt > 0 ? user_pages / ZSWAP_POOL_RATIO : 0, swap_disk_write);
+}
+
+/* 스왑 슬롯 SLOT에 PAGE를 씀 */
+static void
+swap_disk_write(size_t slot, const void *page)
+{
+	disk_sector_t sector = slot * SECTORS_PER_SLOT;
+	for (int i = 0; i < SECTORS_PER_SLOT; i++)
+		disk_write(swap_disk, sector + i, page + DISK_SECTOR_SIZE * i);
+	disk_out_cnt++;
+}
+
+/* 스왑 슬롯 SLOT을 PAGE에 읽음 */
+static void
+swap_disk_read(size_t slot, void *page)
+{
+	disk_sector_t sector = slot * SECTORS_PER_SLOT;
+	for (int i = 0; i < SECTORS_PER_SLOT; i++)
+		disk_read(swap_disk, sector + i, page + DISK_SECTOR_SIZE * i);
+	disk_in_cnt++;
+}
+
+/* 구간의 hash 함수들 - 시작 슬롯 / 끝 슬롯 기준 */
+static uint64_t
+extent_start_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	return hash_bytes(&hash_entry(e, struct swap_extent, start_elem)->start, sizeof(size_t));
+}
+
+static bool
+extent_start_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	return hash_entry(a, struct swap_extent, start_elem)->start < hash_entry(b, struct swap_extent, start_elem)->start;
+}
+
+static uint64_t
+extent_end_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct swap_extent *ext = hash_entry(e, struct swap_extent, end_elem);
+	size_t end = ext->start + ext->cnt;
+	return hash_bytes(&end, sizeof end);
+}
+
+static bool
+extent_end_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED)
+{
+	const struct swap_extent *a = hash_entry(a_, struct swap_extent, end_elem);
+	const struct swap_extent *b = hash_entry(b_, struct swap_extent, end_elem);
+	return a->start + a->cnt < b->start + b->cnt;
+}
+
+/* 슬롯 START부터 CNT개의 빈 구간을 만들어 목록 끝에 추가 - 메모리가 없으면 NULL */
+static struct swap_extent *
+extent_new(size_t start, size_t cnt)
+{
+	struct swap_extent *ext = malloc(sizeof *ext);
+	if (ext == NULL)
+		return NULL;
+	ext->start = start;
+	ext->cnt = cnt;
+	list_push_back(&swap_extents, &ext->elem);
+	hash_insert(&extent_by_start, &ext->start_elem);
+	hash_insert(&extent_by_end, &ext->end_elem);
+	return ext;
+}
+
+/* 빈 구간 EXT를 목록에서 지우고 해제 */
+static void
+extent_delete(struct swap_extent *ext)
+{
+	if (swap_cursor == &ext->elem)
+		swap_cursor = list_next(&ext->elem);
+	list_remove(&ext->elem);
+	hash_delete(&extent_by_start, &ext->start_elem);
+	hash_delete(&extent_by_end, &ext->end_elem);
+	free(ext);
+}
+
+/* SLOT에서 시작하는 빈 구간을 찾음 */
+static struct swap_extent *
+extent_starting_at(size_t slot)
+{
+	struct swap_extent key;
+	struct hash_elem *e;
+
+	key.start = slot;
+	e = hash_find(&extent_by_start, &key.start_elem);
+	return e != NULL ? hash_entry(e, struct swap_extent, start_elem) : NULL;
+}
+
+/* SLOT 바로 앞에서 끝나는 빈 구간을 찾음 */
+static struct swap_extent *
+extent_ending_at(size_t slot)
+{
+	struct swap_extent key;
+	struct hash_elem *e;
+
+	key.start = slot;
+	key.cnt = 0;
+	e = hash_find(&extent_by_end, &key.end_elem);
+	return e != NULL ? hash_entry(e, struct swap_extent, end_elem) : NULL;
+}
+
+/**
+ * @brief 연속된 스왑 슬롯 *CNT개를 할당하는 함수
+ * 커서가 가리키는 구간부터 목록을 한 바퀴 돌며 *CNT개 이상 비어 있는 구간의 앞부분을 떼어 준다.
+ * 그런 구간이 없으면 *CNT를 1로 줄여 한 슬롯만 할당한다.
+ *
+ * @param cnt 원하는 슬롯 수 / 실제로 할당한 슬롯 수
+ * @return size_t 첫 슬롯, 스왑이 가득 찼으면 SWAP_ERROR
+ */
+static size_t
+swap_slot_alloc(size_t *cnt)
+{
+	struct swap_extent *ext = NULL;
+
+	/* NOTE: swap 영역에 빈 공간이 없으면 실패 */
+	if (swap_free_cnt == 0)
+	{
+		slot_fail_cnt++;
+		return SWAP_ERROR;
+	}
+	if (swap_free_cnt < *cnt)
+		*cnt = 1;
+
+	if (swap_cursor == list_end(&swap_extents))
+		swap_cursor = list_begin(&swap_extents);
+	struct list_elem *e = swap_cursor;
+	do
+	{
+		struct swap_extent *cand = list_entry(e, struct swap_extent, elem);
+		slot_scan_cnt++;
+		if (cand->cnt >= *cnt)
+		{
+			ext = cand;
+			break;
+		}
+		e = list_next(e);
+		if (e == list_end(&swap_extents))
+			e = list_begin(&swap_extents);
+	} while (e != swap_cursor);
+
+	/* 연속된 구간이 없으면 커서의 구간에서 한 슬롯 */
+	if (ext == NULL)
+	{
+		*cnt = 1;
+		ext = list_entry(swap_cursor, struct swap_extent, elem);
+	}
+
+	/* 구간의 앞부분을 떼어 줌 - 끝 슬롯은 그대로이므로 start hash만 갱신 */
+	size_t slot = ext->start;
+	swap_cursor = &ext->elem;
+	if (ext->cnt == *cnt)
+		extent_delete(ext);
+	else
+	{
+		hash_delete(&extent_by_start, &ext->start_elem);
+		ext->start += *cnt;
+		ext->cnt -= *cnt;
+		hash_insert(&extent_by_start, &ext->start_elem);
+	}
+	swap_free_cnt -= *cnt;
+	slot_alloc_cnt += *cnt;
+	return slot;
+}
+
+/* 슬롯 SLOT을 빈 구간으로 돌려주고 양옆의 빈 구간과 병합 */
+static void
+swap_slot_free(size_t slot)
+{
+	struct swap_extent *left = extent_ending_at(slot);
+	struct swap_extent *right = extent_starting_at(slot + 1);
+
+	zswap_invalidate(slot);
+	if (left != NULL)
+	{
+		hash_delete(&extent_by_end, &left->end_elem);
+		left->cnt++;
+		if (right != NULL)
+		{
+			left->cnt += right->cnt;
+			extent_delete(right);
+		}
+		hash_insert(&extent_by_end, &left->end_elem);
+	}
+	else if (right != NULL)
+	{
+		hash_delete(&extent_by_start, &right->start_elem);
+		right->start--;
+		right->cnt++;
+		hash_insert(&extent_by_start, &right->start_elem);
+	}
+	else if (extent_new(slot, 1) == NULL)
+	{
+		/* 구간을 만들 메모리가 없으면 슬롯을 잃음 */
+		return;
+	}
+	swap_free_cnt++;
+	slot_free_cnt++;
+}
+
+/**
+ * @brief 스왑 슬롯의 참조를 하나 놓는 함수
+ * 마지막 참조였다면 슬롯을 swap table에 반환한다.
+ *
+ * @param swap_table_idx 슬롯 번호
+ */
+static void
+swap_slot_put(size_t swap_table_idx)
+{
+	ASSERT(swap_refs[swap_table_idx] > 0);
+	if (--swap_refs[swap_table_idx] == 0)
+		swap_slot_free(swap_table_idx);
+}
+
+/**
+ * @brief fork 시 스왑된 페이지를 복사하지 않고 슬롯을 공유하도록 참조를 늘리는 함수
+ *
+ * @param swap_table_idx 슬롯 번호
+ */
+void anon_swap_slot_dup(size_t swap_table_idx)
+{
+	if (swap_table_idx == SWAP_ZERO)
+		return;
+	ASSERT(swap_refs[swap_table_idx] > 0);
+	swap_refs[swap_table_idx]++;
+}
+
+/* PAGE의 스왑 슬롯 번호를 IDX로 바꿈 - 소유 프로세스의 스왑 페이지 수(swap_cnt)를 함께 맞춤 */
+static void
+anon_set_slot(struct page *page, size_t idx)
+{
+	bool was_used = page->anon.swap_table_idx != SWAP_NONE && page->anon.swap_table_idx != SWAP_ZERO;
+	bool used = idx != SWAP_NONE && idx != SWAP_ZERO;
+
+	if (was_used != used)
+		vm_swap_account(&page->owner->spt, used ? 1 : -1);
+	page->anon.swap_table_idx = idx;
+}
+
+/**
+ * @brief 페이지 하나를 새 스왑 슬롯에 쓰는 함수 - 공유 메모리 세그먼트처럼 페이지 구조체 밖에서 슬롯을 가질 때 사용
+ * 모두 0인 페이지는 쓰지 않고 SWAP_ZERO를 돌려준다. 슬롯은 anon_swap_load나 anon_swap_drop으로 돌려준다.
+ *
+ * @param kva 쓸 페이지
+ * @param slot 쓴 슬롯
+ * @return false 스왑이 가득 참
+ */
+bool anon_swap_save(const void *kva, size_t *slot)
+{
+	size_t cnt = 1;
+
+	if (page_is_zero(kva))
+	{
+		*slot = SWAP_ZERO;
+		zero_out_cnt++;
+		return true;
+	}
+	*slot = swap_slot_alloc(&cnt);
+	if (*slot == SWAP_ERROR)
+		return false;
+	if (!zswap_store(*slot, kva))
+		swap_disk_write(*slot, kva);
+	swap_refs[*slot] = 1;
+	swap_out_cnt++;
+	return true;
+}
+
+/* anon_swap_save로 쓴 SLOT을 KVA에 읽고 슬롯을 돌려줌 - 슬롯이 없거나(SWAP_NONE) SWAP_ZERO면 0으로 채움 */
+void anon_swap_load(size_t slot, void *kva)
+{
+	if (slot == SWAP_NONE || slot == SWAP_ZERO)
+	{
+		memset(kva, 0, PGSIZE);
+		return;
+	}
+	if (!zswap_load(slot, kva))
+		swap_disk_read(slot, kva);
+	swap_slot_put(slot);
+	swap_in_cnt++;
+}
+
+/* anon_swap_save로 쓴 SLOT을 읽지 않고 돌려줌 */
+void anon_swap_drop(size_t slot)
+{
+	if (slot != SWAP_NONE && slot != SWAP_ZERO)
+		swap_slot_put(slot);
+}
+
+/* 스왑 슬롯 수 - overcommit 한도 계산에 사용 */
+size_t anon_swap_slots(void)
+{
+	return swap_slot_cnt;
 }
 
 /* Initialize the file mapping - 익명 페이지를 위한 초기화 함수 */
@@ -42,11 +417,81 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 	 * 현재 비어있는 구조체인 anon_page의 정보를 업데이트할 필요가 있다.
 	 * 이 함수는 익명 페이지를 초기화하는데 사용된다. (i.e. VM_ANON)
 	 */
+	/* NOTE: anon_page는 uninit_page와 union이므로 덮어쓰기 전에 aux를 읽음 */
+	void *aux = page->uninit.aux;
+	bool from_file = page->uninit.init == lazy_load_segment && ((struct page_load_info *)aux)->read_bytes > 0;
+
 	/* Set up the handler */
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
-	anon_page->swap_table_idx = -1;
+	anon_page->swap_table_idx = SWAP_NONE;
+	anon_page->text = type & VM_TEXT ? aux : NULL;
+	anon_page->load = from_file && !(type & VM_TEXT) ? aux : NULL;
+	anon_page->readahead = false;
+	anon_page->shm = type & VM_SHM ? aux : NULL;
+	return true;
+}
+
+/**
+ * @brief 미리 읽어 둔 페이지가 쓰였는지에 따라 readahead 창 크기를 조절하는 함수
+ * 쓰인 페이지가 있으면 창을 하나 늘리고, 쓰이지 않고 버려지면 창을 반으로 줄인다.
+ *
+ * @param page 검사할 anon 페이지 (미리 읽은 페이지가 아니면 무시)
+ * @param used 페이지가 접근되었는지 여부
+ */
+void anon_readahead_check(struct page *page, bool used)
+{
+	if (!page->anon.readahead)
+		return;
+	page->anon.readahead = false;
+
+	if (used)
+	{
+		ra_used_cnt++;
+		if (ra_window < SWAP_CLUSTER)
+			ra_window++;
+	}
+	else if (ra_window > 1)
+		ra_window /= 2;
+}
+
+/**
+ * @brief PAGE와 함께 내보냈던 바로 뒤의 페이지들을 남는 frame에 미리 읽어 오는 함수
+ * 같은 클러스터로 연속된 슬롯에 쓰인 페이지만 읽는다.
+ *
+ * @param page 폴트로 읽어 온 페이지
+ * @param slot PAGE가 있던 슬롯
+ */
+static void
+anon_swap_readahead(struct page *page, size_t slot)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	size_t k;
+
+	/* 순차 접근이면 창이 1이어도 다시 키움 */
+	if (page->owner == ra_last && page->va == ra_next_va && ra_window < SWAP_CLUSTER)
+		ra_window++;
+	/* madvise(SEQUENTIAL)이면 클러스터 전체를 읽음 */
+	size_t window = page->advice == MADV_SEQUENTIAL ? SWAP_CLUSTER : ra_window;
+
+	for (k = 1; k < window; k++)
+	{
+		struct page *next = spt_find_page(spt, page->va + k * PGSIZE);
+		if (next == NULL || VM_TYPE(next->operations->type) != VM_ANON || next->frame != NULL || next->anon.swap_table_idx != slot + k || swap_refs[slot + k] != 1)
+			break;
+
+		/* readahead 표시 - 다시 readahead를 일으키지 않음 */
+		next->anon.readahead = true;
+		if (!vm_claim_page_nowait(next))
+		{
+			next->anon.readahead = false;
+			break;
+		}
+		ra_cnt++;
+	}
+	ra_last = page->owner;
+	ra_next_va = page->va + k * PGSIZE;
 }
 
 /* Swap in the page by read contents from the swap disk. */
@@ -54,45 +499,161 @@ static bool
 anon_swap_in(struct page *page, void *kva)
 {
 	struct anon_page *anon_page = &page->anon;
+
+	/* NOTE: [VM] text 페이지는 실행 파일에서 다시 읽음 */
+	if (anon_page->text != NULL)
+		return lazy_load_segment(page, anon_page->text);
+	/* NOTE: [VM] 공유 메모리 페이지는 세그먼트의 슬롯에서 읽음 */
+	if (anon_page->shm != NULL)
+		return shm_swap_in(page, kva);
+
+	/* NOTE: [VM] 내용을 버린 data 페이지는 처음처럼 실행 파일에서 다시 읽음 */
+	if (anon_page->load != NULL && anon_page->swap_table_idx == SWAP_NONE)
+		return lazy_load_segment(page, anon_page->load);
+
+	/* NOTE: [VM] 모두 0이라 스왑에 쓰지 않은 페이지는 0으로 채움 */
+	if (anon_page->swap_table_idx == SWAP_ZERO)
+	{
+		memset(kva, 0, PGSIZE);
+		anon_set_slot(page, SWAP_NONE);
+		return true;
+	}
+
 	// swap table 참조 swap_table_idx 사용
-	// 해당 디스크 내용 읽어오기 disk_read -> frame에 8번 복사
-	size_t start_idx = anon_page->swap_table_idx;
-	for (int i = 0; i < PGSIZE / DISK_SECTOR_SIZE; i++)
+	// 압축 캐시에 없을 때만 디스크 내용 읽어오기
+	size_t slot = anon_page->swap_table_idx;
+	if (!zswap_load(slot, kva))
+		swap_disk_read(slot, kva);
+	// 슬롯을 공유하는 페이지가 없으면 슬롯 반환
+	swap_slot_put(slot);
+
+	anon_set_slot(page, SWAP_NONE);
+
+	/* NOTE: [VM] 폴트로 읽은 페이지면 함께 내보낸 이웃 페이지를 미리 읽음 (madvise(RANDOM)이면 읽지 않음) */
+	if (!anon_page->readahead)
 	{
-		disk_read(swap_disk, start_idx + i, kva + DISK_SECTOR_SIZE * i);
+		swap_in_cnt++;
+		if (page->advice != MADV_RANDOM)
+			anon_swap_readahead(page, slot);
 	}
-	// bitmap 초기화
-	bitmap_set_multiple(swap_table, start_idx, PGSIZE / DISK_SECTOR_SIZE, false);
+	return true;
+}
 
-	anon_page -> swap_table_idx = -1;
+/* KVA의 내용이 모두 0인지 확인 */
+static bool
+page_is_zero(const void *kva)
+{
+	const uint64_t *p = kva;
+	for (size_t i = 0; i < PGSIZE / sizeof *p; i++)
+		if (p[i] != 0)
+			return false;
+	return true;
+}
+
+/* 클러스터에 함께 내보낼 수 있는 페이지인지 - 혼자 쓰는 frame에 있고 최근 접근되지 않은 anon 페이지
+ * 모두 0인 페이지는 따로 내보낼 때 슬롯 없이 처리되므로 제외 */
+static bool
+anon_cluster_ok(struct page *page)
+{
+	return page != NULL && VM_TYPE(page->operations->type) == VM_ANON && page->anon.text == NULL && page->anon.shm == NULL && page->frame != NULL && page->frame->pin_cnt == 0 && list_size(&page->frame->page_list) == 1 && !pml4_is_accessed(page->owner->pml4, page->va) && !page_is_zero(page->frame->kva);
 }
 
 /* Swap out the page by writing contents to the swap disk. */
 static bool
 anon_swap_out(struct page *page)
 {
-	struct anon_page *anon_page = &page->anon;
-	uint64_t *pml4 = page->owner->pml4;
-	void *upage = page->va;
+	struct frame *frame = page->frame;
+	struct page *cluster[SWAP_CLUSTER];
+	size_t cnt = 1;
 
-	// 빈 슬롯 찾을 때 swap table 사용 - bitmap_scan
-	size_t start_idx = bitmap_scan_and_flip(swap_table, 0, PGSIZE / DISK_SECTOR_SIZE, false);
+	/* NOTE: [VM] text 페이지는 실행 파일에서 다시 읽을 수 있으므로 스왑에 쓰지 않음 */
+	if (page->anon.text != NULL)
+	{
+		while (!list_empty(&frame->page_list))
+		{
+			struct page *p = list_entry(list_front(&frame->page_list), struct page, f_elem);
+			anon_set_slot(p, SWAP_NONE);
+			vm_page_set_frame(p, NULL);
+			list_remove(&p->f_elem);
+			pml4_clear_page(p->owner->pml4, p->va);
+		}
+		return true;
+	}
 
-	// 스왑 영역 - page 매핑 - bitmap idx 저장
-	anon_page->swap_table_idx = start_idx;
+	/* NOTE: [VM] 공유 메모리 페이지는 세그먼트의 슬롯에 씀 - 세그먼트를 매핑한 모든 페이지를 함께 내보냄 */
+	if (page->anon.shm != NULL)
+		return shm_swap_out(page);
 
-	// swap_disk에 복사 - disk_write
-	for (int i = 0; i < PGSIZE / DISK_SECTOR_SIZE; i++)
+	/* NOTE: [VM] 모두 0인 페이지는 슬롯도 디스크 I/O도 없이 SWAP_ZERO로 기록 */
+	if (page_is_zero(frame->kva))
 	{
-		disk_write(swap_disk, start_idx + i, page->frame->kva + DISK_SECTOR_SIZE * i);
+		while (!list_empty(&frame->page_list))
+		{
+			struct page *p = list_entry(list_front(&frame->page_list), struct page, f_elem);
+			anon_readahead_check(p, pml4_is_accessed(p->owner->pml4, p->va));
+			anon_set_slot(p, SWAP_ZERO);
+			vm_page_set_frame(p, NULL);
+			list_remove(&p->f_elem);
+			pml4_clear_page(p->owner->pml4, p->va);
+		}
+		zero_out_cnt++;
+		return true;
 	}
 
-	// frame - page 매핑 해제
-	page->frame = NULL;
-	list_remove(&page->f_elem);
-	pml4_clear_page(pml4, upage);
+	/* NOTE: [VM] 바로 뒤의 가상 페이지들도 함께 연속된 슬롯으로 내보냄 */
+	cluster[0] = page;
+	if (list_size(&frame->page_list) == 1)
+		while (cnt < SWAP_CLUSTER && anon_cluster_ok(spt_find_page(&page->owner->spt, page->va + cnt * PGSIZE)))
+		{
+			cluster[cnt] = spt_find_page(&page->owner->spt, page->va + cnt * PGSIZE);
+			cnt++;
+		}
+
+	// 빈 슬롯 찾을 때 swap table 사용
+	size_t slot = swap_slot_alloc(&cnt);
+	/* NOTE: [VM] 스왑이 가득 차면 아무것도 바꾸지 않고 실패 - evict하는 쪽에서 처리 */
+	if (slot == SWAP_ERROR)
+		return false;
+
+	/* 디스크에 쓰는 동안 다른 스레드가 함께 내보낼 frame을 고르지 않도록 고정 */
+	for (size_t k = 1; k < cnt; k++)
+		cluster[k]->frame->pin_cnt++;
+
+	// 압축 캐시에 넣고, 압축이 잘 안 되거나 캐시에 자리가 없으면 swap_disk에 복사
+	for (size_t k = 0; k < cnt; k++)
+		if (!zswap_store(slot + k, cluster[k]->frame->kva))
+			swap_disk_write(slot + k, cluster[k]->frame->kva);
+	swap_out_cnt += cnt;
+	swap_cluster_cnt++;
+
+	/* NOTE: [VM] COW - frame을 공유하는 모든 anon 페이지가 같은 슬롯을 가리킴
+	 * frame은 evict하는 쪽에서 재사용하므로 해제하지 않음 */
+	while (!list_empty(&frame->page_list))
+	{
+		struct page *p = list_entry(list_front(&frame->page_list), struct page, f_elem);
+		ASSERT(VM_TYPE(p->operations->type) == VM_ANON);
+		anon_readahead_check(p, pml4_is_accessed(p->owner->pml4, p->va));
+
+		// 스왑 영역 - page 매핑 - 슬롯 번호 저장
+		anon_set_slot(p, slot);
+		swap_refs[slot]++;
+
+		// frame - page 매핑 해제
+		vm_page_set_frame(p, NULL);
+		list_remove(&p->f_elem);
+		pml4_clear_page(p->owner->pml4, p->va);
+	}
 
-	/* TODO: swap 영역에 빈 공간 없으면 PANIC */
+	/* 함께 내보낸 페이지들의 frame은 바로 해제 */
+	for (size_t k = 1; k < cnt; k++)
+	{
+		struct page *p = cluster[k];
+		p->frame->pin_cnt--;
+		anon_readahead_check(p, false);
+		anon_set_slot(p, slot + k);
+		swap_refs[slot + k] = 1;
+		vm_frame_unlink(p);
+	}
 
 	return true;
 }
@@ -103,9 +664,69 @@ anon_destroy(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
 
-	if (is_interior (&page->f_elem))
-		list_remove(&page->f_elem);
+	/* NOTE: [VM] 공유 메모리 페이지는 세그먼트가 내용을 가짐 */
+	if (anon_page->shm != NULL)
+	{
+		shm_destroy(page);
+		return;
+	}
+
+	if (page->frame != NULL && page->owner->pml4 != NULL)
+		anon_readahead_check(page, pml4_is_accessed(page->owner->pml4, page->va));
+
+	/* NOTE: [VM] frame은 공유 중일 수 있으므로 마지막 페이지만 frame을 해제 */
+	vm_frame_unlink(page);
+
+	if (anon_page->swap_table_idx != SWAP_NONE && anon_page->swap_table_idx != SWAP_ZERO)
+		swap_slot_put(anon_page->swap_table_idx);
+	anon_set_slot(page, SWAP_NONE);
+}
 
-	if (anon_page->swap_table_idx != -1) 
-		bitmap_set_multiple(swap_table, anon_page->swap_table_idx, PGSIZE / DISK_SECTOR_SIZE, false);
+/**
+ * @brief madvise(DONTNEED) - anon 페이지의 내용을 버리는 함수
+ * text 페이지는 frame만 내려놓아 다음 폴트에 실행 파일에서 다시 읽고,
+ * 나머지는 frame과 스왑 슬롯을 돌려준 뒤 실행 파일에서 읽은 data 페이지는 다음 폴트에 파일에서 다시 읽고,
+ * 그 밖의 페이지는 모두 0인 페이지로 표시해 다음 폴트에 0으로 채운다.
+ *
+ * @param page 버릴 anon 페이지
+ * @return true 내려놓은 frame이나 스왑 슬롯이 있음
+ */
+bool anon_discard(struct page *page)
+{
+	struct anon_page *anon_page = &page->anon;
+	bool dropped = page->frame != NULL;
+
+	/* NOTE: [VM] 공유 메모리 페이지는 매핑만 내려놓음 - 내용은 세그먼트에 남음 */
+	if (anon_page->shm != NULL)
+		return shm_discard(page);
+
+	anon_page->readahead = false;
+	vm_frame_unlink(page);
+	if (anon_page->text != NULL)
+		return dropped;
+
+	if (anon_page->swap_table_idx != SWAP_NONE && anon_page->swap_table_idx != SWAP_ZERO)
+	{
+		swap_slot_put(anon_page->swap_table_idx);
+		dropped = true;
+	}
+	anon_set_slot(page, anon_page->load != NULL ? SWAP_NONE : SWAP_ZERO);
+	return dropped;
+}
+
+/* Prints swap statistics. */
+void anon_print_stats(void)
+{
+	printf("Swap: %lld pages out in %lld clusters, %lld pages in, "
+		   "%lld read ahead (%lld used), window %zu\n",
+		   swap_out_cnt, swap_cluster_cnt, swap_in_cnt, ra_cnt, ra_used_cnt,
+		   ra_window);
+	printf("Swap slots: %zu of %zu free in %zu extents, %lld allocated, "
+		   "%lld freed, %lld extents scanned, %lld failed\n",
+		   swap_free_cnt, swap_slot_cnt, list_size(&swap_extents),
+		   slot_alloc_cnt, slot_free_cnt, slot_scan_cnt, slot_fail_cnt);
+	printf("Swap disk: %lld pages written, %lld pages read, "
+		   "%lld zero pages elided\n",
+		   disk_out_cnt, disk_in_cnt, zero_out_cnt);
+	zswap_print_stats();
 }
@@ -1,17 +1,64 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
+#include <stdio.h>
+#include <string.h>
+#include <syscall-nr.h>
 #include "vm/vm.h"
+#include "vm/vma.h"
 #include "userprog/process.h"
 #include "threads/vaddr.h"
 #include "threads/mmu.h"
 #include "vm/vm.h"
 #include "userprog/syscall.h"
 #include "lib/kernel/list.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include <stdlib.h>
 
 static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
 
+/* NOTE: [VM] 파일 매핑 readahead
+ * 한 프로세스가 동시에 추적하는 매핑 수와 처음 순차 접근을 발견했을 때의 창 크기 (페이지) */
+#define FILE_RA_STREAMS 8
+#define FILE_RA_INIT 4
+
+static struct list ra_queue;	 /* readahead 스레드가 읽을 file_ra */
+static struct semaphore ra_sema; /* ra_queue의 요청 수 */
+
+static long long ra_issue_cnt; /* readahead 요청 수 */
+static long long ra_page_cnt;  /* 미리 읽은 페이지 수 */
+static long long ra_hit_cnt;   /* 미리 읽어 둔 페이지로 처리한 폴트 수 */
+static long long ra_wait_cnt;  /* 그중 읽기가 끝나길 기다린 폴트 수 */
+static long long ra_used_cnt;  /* 미리 매핑한 뒤 쓰인 페이지 수 */
+static long long ra_waste_cnt; /* 쓰이지 않고 버려진 페이지 수 */
+static size_t ra_window_max;   /* 가장 컸던 창 */
+
+/* NOTE: [VM] 변경된 file 페이지 writeback
+ * writeback 스레드는 WB_INTERVAL 틱마다 frame table을 돌며 변경된 페이지를
+ * WB_BATCH개씩 모아 파일 offset 순으로 쓴다. 한 묶음을 쓰는 동안 파일 락을 한 번만 잡는다. */
+#define WB_INTERVAL TIMER_FREQ
+#define WB_BATCH 64
+
+/* 쓸 페이지 묶음 - 모은 페이지는 이미 dirty 비트를 지운 상태 */
+struct file_wb
+{
+	struct page *pages[WB_BATCH];
+	size_t cnt;
+};
+
+static long long wb_daemon_cnt; /* writeback 스레드가 쓴 페이지 수 */
+static long long wb_batch_cnt;	/* writeback 스레드가 쓴 묶음 수 */
+static long long wb_sync_cnt;	/* msync로 쓴 페이지 수 */
+static long long wb_unmap_cnt;	/* munmap, 종료, eviction에서 쓴 페이지 수 */
+
+static void file_ra_daemon(void *aux);
+static void file_ra_drop(struct file_ra *ra);
+static void file_wb_daemon(void *aux);
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
 	.swap_in = file_backed_swap_in,
@@ -23,6 +70,14 @@ static const struct page_operations file_ops = {
 /* The initializer of file vm */
 void vm_file_init(void)
 {
+	/* NOTE: [VM] 파일 매핑의 다음 페이지들을 미리 읽는 스레드 */
+	list_init(&ra_queue);
+	sema_init(&ra_sema, 0);
+	if (thread_create("readahead", PRI_DEFAULT, file_ra_daemon, NULL) == TID_ERROR)
+		PANIC("cannot start readahead thread");
+	/* NOTE: [VM] 변경된 페이지를 주기적으로 파일에 쓰는 스레드 */
+	if (thread_create("writeback", PRI_DEFAULT, file_wb_daemon, NULL) == TID_ERROR)
+		PANIC("cannot start writeback thread");
 }
 
 /**
@@ -48,6 +103,8 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva)
 	file_page->file = page_load_info->file;
 	file_page->offset = page_load_info->offset;
 	file_page->read_bytes = page_load_info->read_bytes;
+	file_page->readahead = false;
+	return true;
 }
 
 /* Swap in the page by read contents from the file. */
@@ -72,7 +129,6 @@ file_backed_swap_in(struct page *page, void *kva)
 	file_seek(file, offset);
 	if (file_read(file, page->frame->kva, read_bytes) != (off_t)read_bytes)
 	{
-		palloc_free_page(page->frame->kva);
 		if (flag)
 			lock_release(&filesys_lock);
 		return false;
@@ -84,26 +140,51 @@ file_backed_swap_in(struct page *page, void *kva)
 	return true;
 }
 
+/**
+ * @brief 페이지가 변경되었다면 frame의 내용을 파일에 쓰는 함수
+ * eviction은 다른 프로세스의 페이지에 대해서도 일어나므로 page->va가 아닌 frame의 kva에서 읽는다.
+ * writeback 스레드가 dirty를 지운 뒤 쓰는 중인 페이지를 해제하지 않도록 파일 락을 잡고 확인한다.
+ *
+ * @param page 쓰기를 확인할 페이지
+ */
+static void
+file_backed_writeback(struct page *page)
+{
+	struct file_page *file_page = &page->file;
+	uint64_t *pml4 = page->owner->pml4;
+
+	bool flag = false;
+	if (!lock_held_by_current_thread(&filesys_lock))
+	{
+		lock_acquire(&filesys_lock);
+		flag = true;
+	}
+	/* 페이지가 변경되었다면, 페이지의 dirty를 false로 변경하고 변경된 내용을 파일에 씀
+	 * 쓰는 동안 다른 스레드가 페이지를 바꾸면 다시 dirty가 되도록 먼저 지운다. */
+	if (pml4 != NULL && page->frame != NULL && pml4_is_dirty(pml4, page->va))
+	{
+		pml4_set_dirty(pml4, page->va, false);
+		file_write_at(file_page->file, page->frame->kva, file_page->read_bytes, file_page->offset);
+		wb_unmap_cnt++;
+	}
+	if (flag)
+		lock_release(&filesys_lock);
+}
+
 /* Swap out the page by writeback contents to the file. */
 static bool
 file_backed_swap_out(struct page *page)
 {
 	/* NOTE: swap out 구현 */
-	struct file_page *file_page = &page->file;
 	uint64_t *pml4 = page->owner->pml4;
 	void *upage = page->va;
 
-	/* 페이지가 변경되었는지 확인 */
-	if (pml4_is_dirty(pml4, page->va))
-	{
-		lock_acquire(&filesys_lock);
-		/* 페이지가 변경되었다면, 변경된 내용을 파일에 쓰고, 페이지의 dirty를 false로 변경 */
-		file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->offset);
-		lock_release(&filesys_lock);
-		pml4_set_dirty(pml4, upage, false);
-	}
+	file_backed_writeback(page);
+	/* NOTE: [VM] 미리 읽었지만 쓰이지 않은 페이지면 readahead 창을 줄임 */
+	file_ra_check(page, false);
+
 	/* pml4에서 페이지 제거 */
-	page->frame = NULL;
+	vm_page_set_frame(page, NULL);
 	list_remove(&page->f_elem);
 	pml4_clear_page(pml4, upage);
 
@@ -119,23 +200,28 @@ file_backed_swap_out(struct page *page)
 static void
 file_backed_destroy(struct page *page)
 {
-	struct file_page *file_page = &page->file;
-	uint64_t *pml4 = page->owner->pml4;
-	void *upage = page->va;
+	file_backed_writeback(page);
 
-	/* 페이지가 변경되었는지 확인 */
-	if (pml4_is_dirty(pml4, page->va))
-	{
-		lock_acquire(&filesys_lock);
-		/* 페이지가 변경되었다면, 변경된 내용을 파일에 쓰고, 페이지의 dirty를 false로 변경 */
-		file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->offset);
-		lock_release(&filesys_lock);
-		pml4_set_dirty(pml4, upage, false);
-	}
-	/* pml4에서 페이지 제거 */
-	pml4_clear_page(pml4, upage);
-	if (is_interior (&page->f_elem))
-		list_remove(&page->f_elem);
+	/* pml4에서 페이지 제거 - frame은 공유 중일 수 있으므로 마지막 페이지만 frame을 해제 */
+	vm_frame_unlink(page);
+}
+
+/**
+ * @brief madvise(DONTNEED) - file 페이지의 frame을 내려놓는 함수
+ * 변경된 내용은 파일에 쓰고, 다음 폴트에 파일에서 다시 읽는다.
+ *
+ * @param page
+ * @return true 내려놓은 frame이 있음
+ */
+bool file_backed_discard(struct page *page)
+{
+	if (page->frame == NULL)
+		return false;
+
+	file_backed_writeback(page);
+	file_ra_check(page, pml4_is_accessed(page->owner->pml4, page->va));
+	vm_frame_unlink(page);
+	return true;
 }
 
 /**
@@ -152,71 +238,607 @@ void *
 do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset)
 {
+	/* 매핑할 바이트 수가 파일의 길이보다 큰 경우, 파일의 길이로 제한 */
+	size_t read_bytes = file_length(file) < length ? file_length(file) : length;
+
 	/* file_reopen을 이용해 각 매핑이 파일에 대해 독립적인 참조를 가지도록 함 */
 	struct file *f = file_reopen(file);
-	/* 매핑 시작 주소 저장 */
-	void *start_addr = addr;
-	/* 매핑에 필요한 총 페이지 수 계산 */
-	int total_page_count = length <= PGSIZE ? 1 : length % PGSIZE ? length / PGSIZE + 1
-																  : length / PGSIZE;
+	if (f == NULL)
+		return NULL;
 
-	/* 매핑할 바이트 수가 파일의 길이보다 큰 경우, 파일의 길이로 제한 */
-	size_t read_bytes = file_length(file) < read_bytes ? file_length(file) : read_bytes;
+	/* NOTE: [VM] 매핑 하나를 구간 하나로 등록 - 페이지 구조체는 폴트 때 만든다. */
+	if (!vma_map(&thread_current()->spt, addr, read_bytes, VM_FILE, writable, f, offset, read_bytes))
+	{
+		file_close(f);
+		return NULL;
+	}
+	/* 매핑이 시작된 주소 반환 */
+	return addr;
+}
 
-	while (read_bytes > 0)
+/**
+ * @brief 주어진 주소에서 시작하는 매모리 매핑을 해제하는 함수
+ *
+ * @param addr 해제를 시작할 메모리 주소
+ */
+void do_munmap(void *addr)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct vma *vma = vma_find(spt, addr);
+
+	/* mmap이나 shm_map으로 만든 구간의 시작 주소가 아니면 무시 */
+	if (vma == NULL || vma->start != (uint8_t *)addr || (VM_TYPE(vma->type) != VM_FILE && vma->shm == NULL))
+		return;
+
+	/* NOTE: [VM] 매핑의 readahead 상태 제거 */
+	if (vma->file != NULL)
+		file_ra_forget(spt, vma->file);
+
+	/* 구간과 구간에서 만든 페이지를 모두 해제 - 해제하는 동안 eviction이 페이지를 보지 않도록 VM 락을 잡음 */
+	bool locked = vm_lock_acquire();
+	vma_unmap(spt, addr);
+	vm_lock_release(locked);
+}
+
+/**
+ * @brief PAGE가 변경된 file 페이지이면 dirty 비트를 지우고 WB에 넣는 함수
+ * filesys_lock을 잡은 상태에서 호출한다. 넣은 페이지는 쓰기 전까지 해제되지 않는다.
+ * (해제하는 쪽은 file_backed_writeback에서 락을 기다림)
+ *
+ * @param wb
+ * @param page
+ * @return false WB가 가득 참
+ */
+static bool
+file_wb_add(struct file_wb *wb, struct page *page)
+{
+	uint64_t *pml4 = page->owner->pml4;
+
+	if (wb->cnt == WB_BATCH)
+		return false;
+	if (VM_TYPE(page->operations->type) != VM_FILE || page->frame == NULL || pml4 == NULL || !pml4_is_dirty(pml4, page->va))
+		return true;
+	/* 쓰는 동안 변경되면 다시 dirty가 되도록 먼저 지움 */
+	pml4_set_dirty(pml4, page->va, false);
+	wb->pages[wb->cnt++] = page;
+	return true;
+}
+
+/* 파일과 파일 offset 순서 */
+static int
+file_wb_cmp(const void *a_, const void *b_)
+{
+	const struct page *a = *(struct page *const *)a_;
+	const struct page *b = *(struct page *const *)b_;
+	struct inode *ia = file_get_inode(a->file.file);
+	struct inode *ib = file_get_inode(b->file.file);
+
+	if (ia != ib)
+		return ia < ib ? -1 : 1;
+	return a->file.offset < b->file.offset ? -1 : a->file.offset > b->file.offset;
+}
+
+/* WB의 페이지를 파일 offset 순으로 씀 - filesys_lock을 잡은 상태에서 호출 */
+static void
+file_wb_flush(struct file_wb *wb)
+{
+	qsort(wb->pages, wb->cnt, sizeof *wb->pages, file_wb_cmp);
+	for (size_t i = 0; i < wb->cnt; i++)
 	{
-		/* 한 페이지에 읽을 바이트 수와 0으로 채울 바이트 수 계산 */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
+		struct page *page = wb->pages[i];
+		file_write_at(page->file.file, page->frame->kva, page->file.read_bytes, page->file.offset);
+	}
+	wb->cnt = 0;
+}
 
-		/* 페이지 로드 정보를 위한 구조체 할당 및 초기화 */
-		struct page_load_info *page_load_info = malloc(sizeof(struct page_load_info));
-		page_load_info->file = f;
-		page_load_info->offset = offset;
-		page_load_info->read_bytes = page_read_bytes;
-		page_load_info->zero_bytes = page_zero_bytes;
+/* writeback 스레드 - 주기마다 frame table을 한 바퀴 돌며 변경된 file 페이지를 묶음으로 씀 */
+static void
+file_wb_daemon(void *aux UNUSED)
+{
+	struct file_wb wb;
+
+	wb.cnt = 0;
+	for (;;)
+	{
+		timer_sleep(WB_INTERVAL);
+		/* frame table은 이 스레드를 만든 뒤에 초기화되므로 주기마다 확인 */
+		size_t frame_cnt = vm_frame_cnt();
+		for (size_t i = 0; i < frame_cnt;)
+		{
+			lock_acquire(&filesys_lock);
+			for (; i < frame_cnt && wb.cnt < WB_BATCH; i++)
+			{
+				/* 다른 프로세스의 페이지이므로 인터럽트를 끄고 page_list를 봄
+				 * 묶음에 다 들어가지 않은 페이지는 다음 주기에 씀 */
+				enum intr_level old_level = intr_disable();
+				struct frame *frame = vm_frame_at(i);
+				if (frame->flags & FRAME_USED)
+					for (struct list_elem *e = list_begin(&frame->page_list); e != list_end(&frame->page_list); e = list_next(e))
+						if (!file_wb_add(&wb, list_entry(e, struct page, f_elem)))
+							break;
+				intr_set_level(old_level);
+			}
+			if (wb.cnt > 0)
+			{
+				wb_daemon_cnt += wb.cnt;
+				wb_batch_cnt++;
+				file_wb_flush(&wb);
+			}
+			lock_release(&filesys_lock);
+		}
+	}
+}
+
+/* msync - WB에 PAGE를 넣고, 가득 차면 먼저 씀 */
+static void
+file_wb_push(struct file_wb *wb, struct page *page)
+{
+	if (wb->cnt == WB_BATCH)
+	{
+		wb_sync_cnt += wb->cnt;
+		file_wb_flush(wb);
+	}
+	file_wb_add(wb, page);
+}
+
+/**
+ * @brief msync - 현재 프로세스의 [ADDR, ADDR + LENGTH) 범위에서 변경된 file 페이지를 파일에 쓰는 함수
+ * MS_SYNC면 파일 락을 한 번 잡고 파일 offset 순으로 묶어 쓴 뒤 돌아온다.
+ * MS_ASYNC면 범위만 확인하고, 쓰기는 writeback 스레드가 다음 주기에 한다.
+ *
+ * @param addr 페이지 정렬된 시작 주소
+ * @param length 바이트 수
+ * @param flags MS_ASYNC, MS_SYNC, MS_INVALIDATE
+ * @return int 성공하면 0, 범위에 매핑되지 않은 주소가 있으면 -1
+ */
+int do_msync(void *addr, size_t length, int flags)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *va = addr, *end = va + length;
+	bool sync = flags & MS_SYNC;
+	struct file_wb wb;
+	int ret = 0;
 
-		/* 페이지 할당 및 초기화. 실패 시 NULL 반환 */
-		if (!vm_alloc_page_with_initializer(VM_FILE, addr, writable, lazy_load_segment, (void *)page_load_info))
+	bool flag = false;
+	if (sync && !lock_held_by_current_thread(&filesys_lock))
+	{
+		lock_acquire(&filesys_lock);
+		flag = true;
+	}
+
+	wb.cnt = 0;
+	while (va < end)
+	{
+		struct vma *vma = vma_find(spt, va);
+		if (vma == NULL)
 		{
-			free(page_load_info);
+			/* 구간 밖의 페이지 (스택)는 파일과 관계없음 */
+			if (spt_find_page(spt, va) == NULL)
+			{
+				ret = -1;
+				break;
+			}
+			va += PGSIZE;
+			continue;
+		}
+
+		uint8_t *last = vma->end < end ? vma->end : end;
+		if (sync && VM_TYPE(vma->type) == VM_FILE)
+		{
+			/* 범위가 spt보다 크면 범위의 모든 주소 대신 spt의 페이지를 훑음 */
+			if ((size_t)(last - va) / PGSIZE > hash_size(&spt->hash))
+			{
+				struct hash_iterator i;
+				hash_first(&i, &spt->hash);
+				while (hash_next(&i))
+				{
+					struct page *page = hash_entry(hash_cur(&i), struct page, hash_elem);
+					if ((uint8_t *)page->va >= va && (uint8_t *)page->va < last)
+						file_wb_push(&wb, page);
+				}
+			}
+			else
+				for (uint8_t *p = va; p < last; p += PGSIZE)
+				{
+					struct page *page = spt_find_page(spt, p);
+					if (page != NULL)
+						file_wb_push(&wb, page);
+				}
+		}
+		va = last;
+	}
+	wb_sync_cnt += wb.cnt;
+	file_wb_flush(&wb);
+
+	if (flag)
+		lock_release(&filesys_lock);
+	return ret;
+}
+
+/**
+ * @brief PAGE가 파일 매핑의 페이지이면 파일 위치를 구하는 함수
+ *
+ * @param page
+ * @param file 매핑의 파일
+ * @param ofs 파일 내 offset
+ * @param bytes 파일에서 읽을 바이트 수
+ * @return true
+ * @return false 파일 매핑의 페이지가 아님
+ */
+static bool
+file_ra_pos(struct page *page, struct file **file, off_t *ofs, size_t *bytes)
+{
+	if (VM_TYPE(page->operations->type) == VM_FILE)
+	{
+		*file = page->file.file;
+		*ofs = page->file.offset;
+		*bytes = page->file.read_bytes;
+		return true;
+	}
+	if (VM_TYPE(page->operations->type) == VM_UNINIT && VM_TYPE(page->uninit.type) == VM_FILE)
+	{
+		struct page_load_info *info = page->uninit.aux;
+		*file = info->file;
+		*ofs = info->offset;
+		*bytes = info->read_bytes;
+		return true;
+	}
+	return false;
+}
+
+/* SPT에서 FILE 매핑의 readahead 상태를 찾음 */
+static struct file_ra *
+file_ra_find(struct supplemental_page_table *spt, struct file *file)
+{
+	for (struct list_elem *e = list_begin(&spt->ra_list); e != list_end(&spt->ra_list); e = list_next(e))
+	{
+		struct file_ra *ra = list_entry(e, struct file_ra, elem);
+		if (ra->file == file)
+			return ra;
+	}
+	return NULL;
+}
+
+/**
+ * @brief FILE 매핑의 readahead 상태를 찾고, 없으면 새로 만드는 함수
+ * 가장 최근에 쓴 상태가 list 앞에 오도록 하고, 매핑이 너무 많으면 가장 오래된 상태를 버린다.
+ * list는 eviction 중인 다른 스레드도 읽으므로 인터럽트를 끄고 바꾼다.
+ *
+ * @param spt 현재 프로세스의 spt
+ * @param file 매핑의 파일
+ * @return struct file_ra* 메모리가 부족하면 NULL
+ */
+static struct file_ra *
+file_ra_get(struct supplemental_page_table *spt, struct file *file)
+{
+	struct file_ra *ra = file_ra_find(spt, file);
+	enum intr_level old_level;
+
+	if (ra == NULL)
+	{
+		if (list_size(&spt->ra_list) >= FILE_RA_STREAMS)
+			file_ra_drop(list_entry(list_back(&spt->ra_list), struct file_ra, elem));
+		ra = malloc(sizeof *ra);
+		if (ra == NULL)
 			return NULL;
+		ra->file = file;
+		ra->last_va = NULL;
+		ra->window = FILE_RA_INIT;
+		ra->buf_cnt = 0;
+		ra->orphan = false;
+		sema_init(&ra->done, 0);
+	}
+	else
+	{
+		old_level = intr_disable();
+		list_remove(&ra->elem);
+		intr_set_level(old_level);
+	}
+	old_level = intr_disable();
+	list_push_front(&spt->ra_list, &ra->elem);
+	intr_set_level(old_level);
+	return ra;
+}
+
+/* 미리 읽어 둔 frame들을 모두 돌려줌 - 읽기가 끝난 뒤에 호출 */
+static void
+file_ra_release(struct file_ra *ra)
+{
+	/* readahead 스레드가 직접 해제할 때도 frame table을 바꾸므로 VM 락을 잡음 */
+	bool locked = vm_lock_acquire();
+	for (size_t i = 0; i < ra->buf_cnt; i++)
+		vm_frame_free_unused(ra->buf_kva[i]);
+	vm_lock_release(locked);
+	ra_waste_cnt += ra->buf_cnt;
+	ra->buf_cnt = 0;
+}
+
+/**
+ * @brief readahead 상태를 spt에서 빼고 해제하는 함수
+ * 아직 readahead 스레드가 읽는 중이면 기다리지 않고 스레드에 해제를 맡긴다.
+ * (VM 락을 잡은 채 호출될 수 있으므로 읽기가 끝나길 기다리면 교착 상태가 될 수 있음)
+ *
+ * @param ra
+ */
+static void
+file_ra_drop(struct file_ra *ra)
+{
+	enum intr_level old_level = intr_disable();
+	list_remove(&ra->elem);
+	if (ra->buf_cnt > 0 && !sema_try_down(&ra->done))
+	{
+		ra->orphan = true;
+		intr_set_level(old_level);
+		return;
+	}
+	intr_set_level(old_level);
+
+	file_ra_release(ra);
+	free(ra);
+}
+
+/**
+ * @brief readahead 스레드 - 대기열의 요청마다 buf의 페이지들을 파일에서 읽음
+ * 다 읽으면 done을 올리고, 그 사이 매핑이 사라졌으면 frame과 상태를 직접 해제한다.
+ */
+static void
+file_ra_daemon(void *aux UNUSED)
+{
+	for (;;)
+	{
+		sema_down(&ra_sema);
+		enum intr_level old_level = intr_disable();
+		struct file_ra *ra = list_entry(list_pop_front(&ra_queue), struct file_ra, q_elem);
+		intr_set_level(old_level);
+
+		for (size_t i = 0; i < ra->buf_cnt; i++)
+		{
+			lock_acquire(&filesys_lock);
+			off_t n = file_read_at(ra->file, ra->buf_kva[i], ra->buf_bytes[i], ra->buf_ofs[i]);
+			lock_release(&filesys_lock);
+			/* 다 읽지 못한 페이지는 매핑하지 않도록 표시 - 매핑 페이지의 read_bytes는 0이 아님 */
+			if (n != (off_t)ra->buf_bytes[i])
+				ra->buf_bytes[i] = 0;
+			memset(ra->buf_kva[i] + ra->buf_bytes[i], 0, PGSIZE - ra->buf_bytes[i]);
 		}
 
-		/* 생성된 페이지에 총 페이지 개수 저장 */
-		spt_find_page(&thread_current()->spt, addr)->mapped_page_count = total_page_count;
+		old_level = intr_disable();
+		bool orphan = ra->orphan;
+		if (!orphan)
+			sema_up(&ra->done);
+		intr_set_level(old_level);
+		if (orphan)
+		{
+			file_ra_release(ra);
+			free(ra);
+		}
+	}
+}
 
-		/* Advance. */
-		addr += PGSIZE;
-		offset += page_read_bytes;
-		read_bytes -= page_read_bytes;
+/**
+ * @brief VA부터 창 크기만큼 같은 파일의 연속된 페이지를 readahead 스레드에 읽게 하는 함수
+ * 남는 frame이 있는 만큼만 읽고, 아직 올라오지 않은 페이지에서 멈춘다.
+ *
+ * @param ra 미리 읽어 둔 페이지가 없는 readahead 상태
+ * @param va 첫 페이지 주소
+ */
+static void
+file_ra_issue(struct file_ra *ra, uint8_t *va)
+{
+	struct thread *curr = thread_current();
+	struct file *file;
+	off_t ofs;
+	size_t bytes, cnt;
+
+	ASSERT(ra->buf_cnt == 0);
+	for (cnt = 0; cnt < ra->window; cnt++, va += PGSIZE)
+	{
+		struct page *page = vma_get_page(&curr->spt, va);
+		if (page == NULL || page->frame != NULL || pml4_get_page(curr->pml4, va) != NULL)
+			break;
+		if (!file_ra_pos(page, &file, &ofs, &bytes) || file != ra->file || (cnt > 0 && ofs != ra->buf_ofs[cnt - 1] + PGSIZE))
+			break;
+		void *kva = vm_frame_alloc_nowait();
+		if (kva == NULL)
+			break;
+		ra->buf_kva[cnt] = kva;
+		ra->buf_ofs[cnt] = ofs;
+		ra->buf_bytes[cnt] = bytes;
 	}
-	/* 매핑이 시작된 주소 반환 */
-	return start_addr;
+	if (cnt == 0)
+		return;
+
+	ra->buf_va = va - cnt * PGSIZE;
+	ra->buf_cnt = cnt;
+	ra_issue_cnt++;
+	ra_page_cnt += cnt;
+	if (ra->window > ra_window_max)
+		ra_window_max = ra->window;
+
+	enum intr_level old_level = intr_disable();
+	list_push_back(&ra_queue, &ra->q_elem);
+	intr_set_level(old_level);
+	sema_up(&ra_sema);
 }
 
 /**
- * @brief 주어진 주소에서 시작하는 매모리 매핑을 해제하는 함수
+ * @brief 다 읽은 buf의 페이지들을 매핑하는 함수
+ * 그 사이 매핑이 바뀌었거나 이미 올라온 페이지의 frame은 돌려준다.
  *
- * @param addr 해제를 시작할 메모리 주소
+ * @param ra 읽기가 끝난 readahead 상태
+ * @param fault 폴트가 난 페이지
+ * @return true FAULT를 매핑함
+ * @return false
  */
-void do_munmap(void *addr)
+static bool
+file_ra_take(struct file_ra *ra, struct page *fault)
 {
-	/* spt에서 addr에 해당하는 페이지를 가져옴 */
 	struct supplemental_page_table *spt = &thread_current()->spt;
-	struct page *page = spt_find_page(spt, addr);
+	struct file *file;
+	off_t ofs;
+	size_t bytes;
+	bool mapped = false;
 
-	/* 매핑된 총 페이지 수 */
-	int count = page->mapped_page_count;
+	for (size_t i = 0; i < ra->buf_cnt; i++)
+	{
+		struct page *page = spt_find_page(spt, ra->buf_va + i * PGSIZE);
+		if (page != NULL && page->frame == NULL && file_ra_pos(page, &file, &ofs, &bytes) && file == ra->file && ofs == ra->buf_ofs[i] && bytes == ra->buf_bytes[i] && vm_frame_adopt(page, ra->buf_kva[i]))
+		{
+			/* 폴트가 나지 않은 페이지는 쓰였는지 eviction 때 확인 */
+			page->file.readahead = page != fault;
+			mapped |= page == fault;
+			continue;
+		}
+		vm_frame_free_unused(ra->buf_kva[i]);
+		ra_waste_cnt++;
+	}
+	ra->buf_cnt = 0;
+	return mapped;
+}
 
-	/* 모든 매핑된 페이지 해제*/
-	for (int i = 0; i < count; i++)
+/**
+ * @brief 파일 매핑의 페이지에 폴트가 났을 때, 미리 읽어 둔 페이지이면 매핑하는 함수
+ * 읽어 둔 페이지를 모두 매핑하고, 창을 두 배로 키워 그 다음 페이지들을 미리 읽게 한다.
+ * 스트림이 매핑한 페이지를 지나는 동안 readahead 스레드가 다음 창을 읽는다.
+ *
+ * @param page 폴트가 난 페이지
+ * @param unlock 폴트 처리가 VM 락을 직접 잡았음 - 읽기를 기다리는 동안 놓을 수 있음
+ * @return true PAGE를 매핑함
+ * @return false 미리 읽어 둔 페이지가 아님 - 호출자가 직접 올려야 함
+ */
+bool file_ra_map(struct page *page, bool unlock)
+{
+	struct file *file;
+	off_t ofs;
+	size_t bytes;
+
+	if (!file_ra_pos(page, &file, &ofs, &bytes))
+		return false;
+	struct file_ra *ra = file_ra_find(&page->owner->spt, file);
+	if (ra == NULL || ra->buf_cnt == 0 || (uint8_t *)page->va < (uint8_t *)ra->buf_va || (uint8_t *)page->va >= (uint8_t *)ra->buf_va + ra->buf_cnt * PGSIZE)
+		return false;
+
+	if (!sema_try_down(&ra->done))
 	{
-		if (page)
-			spt_remove_page(spt, page);
+		/* 호출자가 잡고 들어온 VM 락은 놓을 수 없고, 놓지 않고 기다리면
+		 * 먼저 온 요청의 frame을 해제하려는 readahead 스레드가 VM 락을 기다리게 됨 */
+		if (!unlock)
+			return false;
+		/* 프로세스의 readahead 상태는 이 스레드만 바꾸므로 락을 놓은 동안에도 그대로 있음 */
+		ra_wait_cnt++;
+		lock_release(&vm_lock);
+		sema_down(&ra->done);
+		lock_acquire(&vm_lock);
+	}
 
-		/* 다음 페이지로 이동 */
-		addr += PGSIZE;
-		page = spt_find_page(spt, addr);
+	uint8_t *end = (uint8_t *)ra->buf_va + ra->buf_cnt * PGSIZE;
+	if (!file_ra_take(ra, page))
+		return false;
+	ra_hit_cnt++;
+	ra->last_va = page->va;
+	ra->window = ra->window * 2 < FILE_RA_MAX ? ra->window * 2 : FILE_RA_MAX;
+	file_ra_issue(ra, end);
+	return true;
+}
+
+/**
+ * @brief 파일 매핑의 페이지를 직접 올린 뒤 접근 패턴에 따라 readahead를 시작하는 함수
+ * 바로 앞 페이지가 이미 매핑되어 있고 지난 폴트보다 뒤의 주소이면 순차 접근으로 보고 다음 페이지들을 미리 읽는다.
+ * 임의 접근이면 창을 반으로 줄인다.
+ *
+ * @param page 폴트로 올린 페이지
+ * @return true readahead 중 (순차 접근)
+ * @return false 파일 매핑이 아니거나 임의 접근
+ */
+bool file_readahead(struct page *page)
+{
+	struct thread *curr = thread_current();
+	struct file *file;
+	off_t ofs;
+	size_t bytes;
+
+	if (!file_ra_pos(page, &file, &ofs, &bytes))
+		return false;
+	struct file_ra *ra = file_ra_get(&curr->spt, file);
+	if (ra == NULL)
+		return false;
+
+	uint8_t *va = page->va;
+	bool seq = va > (uint8_t *)ra->last_va && pml4_get_page(curr->pml4, va - PGSIZE) != NULL;
+	ra->last_va = va;
+	/* madvise(SEQUENTIAL)이면 처음부터 가장 큰 창으로 미리 읽음 */
+	if (page->advice == MADV_SEQUENTIAL)
+	{
+		seq = true;
+		ra->window = FILE_RA_MAX;
+	}
+
+	/* 읽기가 끝났지만 쓰이지 않은 페이지는 버림 */
+	if (ra->buf_cnt > 0 && sema_try_down(&ra->done))
+		file_ra_release(ra);
+
+	if (!seq)
+	{
+		if (ra->window > 1)
+			ra->window /= 2;
+		return false;
+	}
+	/* 아직 앞의 창을 읽는 중 */
+	if (ra->buf_cnt > 0)
+		return true;
+	file_ra_issue(ra, va + PGSIZE);
+	return ra->buf_cnt > 0;
+}
+
+/**
+ * @brief 미리 읽어 매핑한 페이지가 쓰였는지 기록하는 함수
+ * 쓰이지 않고 내보내지면 매핑의 readahead 창을 반으로 줄인다.
+ *
+ * @param page 검사할 file 페이지 (미리 읽은 페이지가 아니면 무시)
+ * @param used 페이지가 접근되었는지 여부
+ */
+void file_ra_check(struct page *page, bool used)
+{
+	if (!page->file.readahead)
+		return;
+	page->file.readahead = false;
+	if (used)
+	{
+		ra_used_cnt++;
+		return;
 	}
+	ra_waste_cnt++;
+
+	/* 다른 프로세스의 페이지일 수 있으므로 인터럽트를 끄고 찾음 */
+	enum intr_level old_level = intr_disable();
+	struct file_ra *ra = file_ra_find(&page->owner->spt, page->file.file);
+	if (ra != NULL && ra->window > 1)
+		ra->window /= 2;
+	intr_set_level(old_level);
+}
+
+/* FILE 매핑의 readahead 상태를 제거 - munmap에서 호출 */
+void file_ra_forget(struct supplemental_page_table *spt, struct file *file)
+{
+	struct file_ra *ra = file_ra_find(spt, file);
+	if (ra != NULL)
+		file_ra_drop(ra);
+}
+
+/* 프로세스의 모든 readahead 상태를 제거 - 프로세스가 끝나거나 exec할 때 호출 */
+void file_ra_kill(struct supplemental_page_table *spt)
+{
+	while (!list_empty(&spt->ra_list))
+		file_ra_drop(list_entry(list_front(&spt->ra_list), struct file_ra, elem));
+}
+
+/* Prints file mapping readahead statistics. */
+void file_print_stats(void)
+{
+	printf("Readahead: %lld windows, %lld pages read ahead (%lld used, %lld wasted), "
+		   "%lld faults mapped read-ahead pages (%lld waited), max window %zu\n",
+		   ra_issue_cnt, ra_page_cnt, ra_used_cnt, ra_waste_cnt,
+		   ra_hit_cnt, ra_wait_cnt, ra_window_max);
+	printf("Writeback: %lld pages by daemon in %lld batches, %lld by msync, %lld on unmap or eviction\n",
+		   wb_daemon_cnt, wb_batch_cnt, wb_sync_cnt, wb_unmap_cnt);
 }
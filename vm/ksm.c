@@ -0,0 +1,226 @@
+/* ksm.c: Kernel same-page merging - a daemon that merges anonymous pages with identical contents. */
+
+#include <stdio.h>
+#include <string.h>
+#include "vm/ksm.h"
+#include "vm/vm.h"
+#include "devices/timer.h"
+#include "lib/kernel/hash.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/thread.h"
+
+/* NOTE: [VM] ksmd는 KSM_SLEEP 틱마다 frame table을 KSM_BATCH개씩 훑는다. */
+#define KSM_BATCH 128
+#define KSM_SLEEP 1
+
+/* NOTE: [VM] KSM - 두 번 연속 같은 checksum이 나온 (안정된) anon 페이지끼리 병합
+ * stable table: 병합되어 읽기 전용으로 공유 중인 frame (checksum -> frame)
+ * unstable table: 이번 회차에 본 병합 후보 frame - 회차가 끝나면 비움
+ * 병합된 페이지에 쓰기가 발생하면 COW(vm_handle_wp)로 다시 나뉜다. */
+static struct hash stable_table, unstable_table;
+static bool ksm_enabled;
+static size_t ksm_cursor;	   /* 다음에 볼 frame 번호 */
+static unsigned ksm_pass = 1;  /* 지금 회차 - frame->ksm_pass가 같으면 unstable table에 있음 */
+static int64_t ksm_start;	   /* ksmd 시작 시각 */
+
+static long long scan_cnt;	  /* 살펴본 후보 페이지 수 */
+static long long merge_cnt;	  /* 다른 frame에 병합한 페이지 수 */
+static long long unmerge_cnt; /* 쓰기로 병합이 풀린 페이지 수 */
+
+static uint64_t ksm_hash(const struct hash_elem *e, void *aux);
+static bool ksm_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+static void ksm_daemon(void *aux);
+
+/* 커널 옵션 -ksm - ksmd를 켬 */
+void ksm_enable(void)
+{
+	ksm_enabled = true;
+}
+
+/* KSM 초기화 - 켜져 있으면 ksmd 스레드를 만듦 */
+void ksm_init(void)
+{
+	hash_init(&stable_table, ksm_hash, ksm_less, NULL);
+	hash_init(&unstable_table, ksm_hash, ksm_less, NULL);
+	if (!ksm_enabled)
+		return;
+
+	ksm_start = timer_ticks();
+	if (thread_create("ksmd", PRI_DEFAULT, ksm_daemon, NULL) == TID_ERROR)
+		PANIC("cannot start ksmd");
+}
+
+static uint64_t
+ksm_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	return hash_entry(e, struct frame, ksm_elem)->ksm_sum;
+}
+
+static bool
+ksm_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	return hash_entry(a, struct frame, ksm_elem)->ksm_sum < hash_entry(b, struct frame, ksm_elem)->ksm_sum;
+}
+
+/* TABLE에서 checksum이 SUM인 frame을 찾음 */
+static struct frame *
+ksm_find(struct hash *table, unsigned sum)
+{
+	struct frame key;
+	struct hash_elem *e;
+
+	key.ksm_sum = sum;
+	e = hash_find(table, &key.ksm_elem);
+	return e != NULL ? hash_entry(e, struct frame, ksm_elem) : NULL;
+}
+
+/* 병합 후보인지 - 한 페이지만 쓰기 가능으로 매핑한, 고정되지 않은 일반 anon 페이지의 frame */
+static bool
+ksm_candidate(struct frame *frame)
+{
+	if ((frame->flags & (FRAME_USED | FRAME_KSM)) != FRAME_USED || frame->pin_cnt > 0 || list_size(&frame->page_list) != 1)
+		return false;
+
+	struct page *page = list_entry(list_front(&frame->page_list), struct page, f_elem);
+	/* 2 MB 매핑은 쓰기 권한을 블록 전체가 함께 쓰므로 제외, 공유 메모리는 세그먼트가 frame을 가지므로 제외 */
+	return VM_TYPE(page->operations->type) == VM_ANON && page->anon.text == NULL && page->anon.shm == NULL && page->writable && page->owner->pml4 != NULL && !pml4_is_huge_page(page->owner->pml4, page->va);
+}
+
+/* 후보 FRAME을 stable table에 올려 읽기 전용으로 바꿈 */
+static void
+ksm_promote(struct frame *frame)
+{
+	struct page *page = list_entry(list_front(&frame->page_list), struct page, f_elem);
+
+	pml4_set_writable(page->owner->pml4, page->va, false);
+	frame->flags |= FRAME_KSM;
+	hash_insert(&stable_table, &frame->ksm_elem);
+}
+
+/* FRAME의 페이지를 같은 내용의 STABLE frame으로 옮김 - 원래 frame은 해제됨 */
+static void
+ksm_merge(struct frame *frame, struct frame *stable)
+{
+	struct page *page = list_entry(list_front(&frame->page_list), struct page, f_elem);
+
+	if (vm_frame_move(page, stable))
+		merge_cnt++;
+}
+
+/**
+ * @brief frame 하나를 살펴보고 가능하면 병합하는 함수
+ * 지난 회차와 checksum이 같은 페이지만 병합한다. stable table에 같은 내용이 있으면 그 frame에,
+ * 없고 이번 회차에 같은 내용의 후보를 봤다면 그 후보를 stable로 올린 뒤 병합한다.
+ *
+ * @param frame 살펴볼 frame (인터럽트를 끈 상태에서 호출)
+ */
+static void
+ksm_scan_frame(struct frame *frame)
+{
+	/* 이번 회차에 이미 unstable table에 있는 frame은 key(checksum)를 바꾸지 않음 */
+	if (!ksm_candidate(frame) || frame->ksm_pass == ksm_pass)
+		return;
+	scan_cnt++;
+
+	unsigned sum = hash_bytes(frame->kva, PGSIZE);
+	if (sum != frame->ksm_sum)
+	{
+		/* 지난 회차 이후 바뀐 페이지는 아직 병합하지 않음 */
+		frame->ksm_sum = sum;
+		return;
+	}
+
+	struct frame *stable = ksm_find(&stable_table, sum);
+	if (stable != NULL)
+	{
+		if (!memcmp(stable->kva, frame->kva, PGSIZE))
+			ksm_merge(frame, stable);
+		return;
+	}
+
+	struct frame *other = ksm_find(&unstable_table, sum);
+	if (other == NULL)
+	{
+		frame->ksm_pass = ksm_pass;
+		hash_insert(&unstable_table, &frame->ksm_elem);
+		return;
+	}
+
+	/* 후보가 그 사이에 해제되거나 바뀌었을 수 있으므로 다시 확인 */
+	if (!ksm_candidate(other) || other->ksm_sum != sum || memcmp(other->kva, frame->kva, PGSIZE))
+		return;
+	hash_delete(&unstable_table, &other->ksm_elem);
+	ksm_promote(other);
+	ksm_merge(frame, other);
+}
+
+/* ksmd - frame table을 조금씩 훑으며 병합 */
+static void
+ksm_daemon(void *aux UNUSED)
+{
+	size_t frame_cnt = vm_frame_cnt();
+
+	for (;;)
+	{
+		/* NOTE: [VM] eviction이 고른 frame이나 해제 중인 페이지를 옮기지 않도록 VM 락을 잡고 훑음 */
+		bool locked = vm_lock_acquire();
+		for (size_t i = 0; i < KSM_BATCH && frame_cnt > 0; i++)
+		{
+			enum intr_level old_level = intr_disable();
+			ksm_scan_frame(vm_frame_at(ksm_cursor));
+			if (++ksm_cursor == frame_cnt)
+			{
+				/* 한 회차가 끝나면 unstable table을 비움 */
+				ksm_cursor = 0;
+				ksm_pass++;
+				hash_clear(&unstable_table, NULL);
+			}
+			intr_set_level(old_level);
+		}
+		vm_lock_release(locked);
+		timer_sleep(KSM_SLEEP);
+	}
+}
+
+/* FRAME이 병합된 frame이면 stable table에서 뺌 - frame을 해제하거나 내보낼 때 호출 */
+void ksm_forget(struct frame *frame)
+{
+	if (!(frame->flags & FRAME_KSM))
+		return;
+	hash_delete(&stable_table, &frame->ksm_elem);
+	frame->flags &= ~FRAME_KSM;
+}
+
+/**
+ * @brief 병합된 FRAME에 쓰기가 발생해 페이지 하나가 떨어져 나갈 때 호출되는 함수
+ *
+ * @param frame 병합된 frame
+ * @param last 마지막 페이지라 frame을 그대로 쓰기 가능하게 바꾸는지 여부
+ */
+void ksm_unmerge(struct frame *frame, bool last)
+{
+	unmerge_cnt++;
+	if (last)
+		ksm_forget(frame);
+}
+
+/* Prints same-page merging statistics. */
+void ksm_print_stats(void)
+{
+	if (!ksm_enabled)
+		return;
+
+	int64_t ticks = timer_elapsed(ksm_start);
+	size_t sharing = 0;
+	struct hash_iterator i;
+
+	hash_first(&i, &stable_table);
+	while (hash_next(&i))
+		sharing += list_size(&hash_entry(hash_cur(&i), struct frame, ksm_elem)->page_list);
+
+	printf("KSM: %lld pages scanned in %u passes (%lld pages/s), "
+		   "%lld merged, %lld unmerged, %zu pages sharing %zu frames\n",
+		   scan_cnt, ksm_pass - 1, ticks > 0 ? scan_cnt * TIMER_FREQ / ticks : 0,
+		   merge_cnt, unmerge_cnt, sharing, hash_size(&stable_table));
+}
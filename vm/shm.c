@@ -0,0 +1,418 @@
+/* shm.c: Shared anonymous memory - named segments that several processes map onto the same frames. */
+
+#include <stdio.h>
+#include <string.h>
+#include <round.h>
+#include "vm/shm.h"
+#include "vm/vm.h"
+#include "vm/vma.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* NOTE: [VM] 공유 메모리 - 이름으로 찾는 세그먼트를 여러 프로세스가 매핑한다.
+ * 세그먼트는 페이지마다 지금 올라와 있는 frame이나 내용을 담은 스왑 슬롯을 기록한다.
+ * 프로세스의 페이지는 처음 폴트가 날 때 그 frame에 쓰기 가능하게 매핑되어 frame->page_list로 공유한다.
+ * frame을 내보내면 매핑한 모든 페이지가 함께 빠지고 내용은 세그먼트의 슬롯에 남는다.
+ * fork한 자식은 구간만 물려받고 폴트 때 같은 frame에 매핑하므로 복사하지 않는다. */
+
+/* 세그먼트의 페이지 하나 */
+struct shm_page
+{
+	struct frame *frame; /* 올라와 있는 frame - 없으면 NULL */
+	size_t slot;		 /* frame이 없을 때 내용을 담은 스왑 슬롯 (SWAP_NONE이면 모두 0) */
+};
+
+struct shm_segment
+{
+	char name[SHM_NAME_MAX + 1];
+	bool named;				 /* shm_unlink 전 - 이름으로 찾을 수 있음 */
+	size_t page_cnt;		 /* 세그먼트의 페이지 수 */
+	size_t map_cnt;			 /* 세그먼트를 매핑한 구간 수 */
+	size_t ref_cnt;			 /* 구간 + 페이지(shm_ref) + 이름 - 0이 되면 해제 */
+	struct list_elem elem;	 /* shm_list */
+	struct shm_page pages[]; /* page_cnt개 */
+};
+
+static struct list shm_list;	  /* 이름이 있는 세그먼트 */
+static struct lock shm_list_lock; /* shm_list와 세그먼트의 참조 수 */
+
+static long long shm_create_cnt; /* 만든 세그먼트 수 */
+static long long shm_attach_cnt; /* 다른 프로세스가 올려 둔 frame에 매핑한 폴트 수 */
+static long long shm_out_cnt;	 /* 스왑에 쓴 페이지 수 */
+static long long shm_in_cnt;	 /* 스왑에서 읽은 페이지 수 */
+static long long shm_keep_cnt;	 /* 마지막 매핑이 빠질 때 스왑이 가득 차 frame을 붙잡아 둔 횟수 */
+
+static void shm_put(struct shm_segment *seg);
+
+void shm_init(void)
+{
+	list_init(&shm_list);
+	lock_init(&shm_list_lock);
+}
+
+/* 이름이 NAME인 세그먼트 - 없으면 NULL. shm_list_lock을 잡은 상태에서 호출 */
+static struct shm_segment *
+shm_find(const char *name)
+{
+	for (struct list_elem *e = list_begin(&shm_list); e != list_end(&shm_list); e = list_next(e))
+	{
+		struct shm_segment *seg = list_entry(e, struct shm_segment, elem);
+		if (!strcmp(seg->name, name))
+			return seg;
+	}
+	return NULL;
+}
+
+/* 모두 0인 PAGE_CNT 페이지짜리 세그먼트를 NAME으로 만듦 - 이름이 참조 하나를 가짐. shm_list_lock을 잡은 상태에서 호출 */
+static struct shm_segment *
+shm_create(const char *name, size_t page_cnt)
+{
+	struct shm_segment *seg = malloc(sizeof *seg + page_cnt * sizeof *seg->pages);
+	if (seg == NULL)
+		return NULL;
+
+	strlcpy(seg->name, name, sizeof seg->name);
+	seg->named = true;
+	seg->page_cnt = page_cnt;
+	seg->map_cnt = 0;
+	seg->ref_cnt = 1;
+	for (size_t i = 0; i < page_cnt; i++)
+	{
+		seg->pages[i].frame = NULL;
+		seg->pages[i].slot = SWAP_NONE;
+	}
+	list_push_back(&shm_list, &seg->elem);
+	shm_create_cnt++;
+	return seg;
+}
+
+/**
+ * @brief 이름이 NAME인 세그먼트를 현재 프로세스의 ADDR에 매핑하는 함수 - 없으면 SIZE 바이트로 만든다.
+ * 세그먼트의 앞 SIZE 바이트(페이지 단위로 올림)를 쓰기 가능하게 매핑한다.
+ *
+ * @param name 세그먼트 이름 (SHM_NAME_MAX자 이하)
+ * @param size 매핑할 바이트 수 - 이미 있는 세그먼트보다 클 수 없음
+ * @param addr 페이지 정렬된 시작 주소
+ * @return void* ADDR, 실패하면 NULL
+ */
+void *do_shm_map(const char *name, size_t size, void *addr)
+{
+	size_t page_cnt = DIV_ROUND_UP(size, PGSIZE);
+	bool created = false;
+
+	if (strlen(name) > SHM_NAME_MAX || page_cnt == 0)
+		return NULL;
+
+	lock_acquire(&shm_list_lock);
+	struct shm_segment *seg = shm_find(name);
+	if (seg == NULL)
+	{
+		seg = shm_create(name, page_cnt);
+		created = seg != NULL;
+	}
+	if (seg == NULL || page_cnt > seg->page_cnt)
+	{
+		lock_release(&shm_list_lock);
+		return NULL;
+	}
+	/* 구간이 참조를 하나 가짐 */
+	seg->ref_cnt++;
+	seg->map_cnt++;
+	lock_release(&shm_list_lock);
+
+	if (!vma_map_shm(&thread_current()->spt, addr, page_cnt * PGSIZE, seg))
+	{
+		shm_vma_put(seg);
+		/* 매핑하려고 만든 세그먼트는 남기지 않음 */
+		if (created)
+			do_shm_unlink(name);
+		return NULL;
+	}
+	return addr;
+}
+
+/**
+ * @brief 세그먼트의 이름을 지우는 함수 - 세그먼트는 마지막 매핑과 페이지가 사라질 때 해제된다.
+ * 같은 이름으로 다시 매핑하면 새 세그먼트를 만든다.
+ *
+ * @return int 성공하면 0, 그런 이름이 없으면 -1
+ */
+int do_shm_unlink(const char *name)
+{
+	lock_acquire(&shm_list_lock);
+	struct shm_segment *seg = shm_find(name);
+	if (seg != NULL)
+	{
+		seg->named = false;
+		list_remove(&seg->elem);
+	}
+	lock_release(&shm_list_lock);
+
+	if (seg == NULL)
+		return -1;
+	shm_put(seg);
+	return 0;
+}
+
+/* 세그먼트의 참조를 하나 늘림 */
+static void
+shm_get(struct shm_segment *seg)
+{
+	lock_acquire(&shm_list_lock);
+	seg->ref_cnt++;
+	lock_release(&shm_list_lock);
+}
+
+/* 세그먼트의 참조를 하나 놓음 - 마지막이면 붙잡아 둔 frame과 스왑 슬롯을 돌려주고 해제 */
+static void
+shm_put(struct shm_segment *seg)
+{
+	lock_acquire(&shm_list_lock);
+	bool last = --seg->ref_cnt == 0;
+	lock_release(&shm_list_lock);
+	if (!last)
+		return;
+
+	/* 페이지가 모두 사라졌으므로 남은 frame은 shm_detach가 붙잡아 둔 것뿐 */
+	bool locked = vm_lock_acquire();
+	for (size_t i = 0; i < seg->page_cnt; i++)
+	{
+		if (seg->pages[i].frame != NULL)
+			vm_frame_unpin(seg->pages[i].frame);
+		anon_swap_drop(seg->pages[i].slot);
+	}
+	vm_lock_release(locked);
+	free(seg);
+}
+
+/* fork, 구간 나누기 - 세그먼트를 매핑한 구간이 하나 늘어남 */
+void shm_vma_get(struct shm_segment *seg)
+{
+	lock_acquire(&shm_list_lock);
+	seg->ref_cnt++;
+	seg->map_cnt++;
+	lock_release(&shm_list_lock);
+}
+
+/* 세그먼트를 매핑한 구간이 사라짐 */
+void shm_vma_put(struct shm_segment *seg)
+{
+	lock_acquire(&shm_list_lock);
+	seg->map_cnt--;
+	lock_release(&shm_list_lock);
+	shm_put(seg);
+}
+
+/* 세그먼트를 다시 매핑할 수 있는지 - 이름이 있거나 매핑한 구간이 있음 */
+static bool
+shm_live(struct shm_segment *seg)
+{
+	lock_acquire(&shm_list_lock);
+	bool live = seg->named || seg->map_cnt > 0;
+	lock_release(&shm_list_lock);
+	return live;
+}
+
+/* vm_initializer - 처음 폴트가 난 공유 메모리 페이지를 세그먼트의 내용으로 채움 */
+static bool
+shm_load(struct page *page, void *aux UNUSED)
+{
+	return shm_swap_in(page, page->frame->kva);
+}
+
+/**
+ * @brief 세그먼트 SEG의 IDX번째 페이지를 현재 프로세스의 UPAGE에 만드는 함수 - 폴트 때 vma_get_page가 호출
+ *
+ * @return false 메모리가 부족하거나 UPAGE에 이미 페이지가 있음
+ */
+bool shm_alloc_page(struct shm_segment *seg, size_t idx, void *upage, bool writable)
+{
+	ASSERT(idx < seg->page_cnt);
+
+	struct shm_ref *ref = malloc(sizeof *ref);
+	if (ref == NULL)
+		return false;
+	ref->seg = seg;
+	ref->idx = idx;
+	shm_get(seg);
+
+	if (!vm_alloc_page_with_initializer(VM_ANON | VM_SHM, upage, writable, shm_load, ref))
+	{
+		shm_ref_free(ref);
+		return false;
+	}
+	return true;
+}
+
+/* PAGE가 공유 메모리 페이지면 세그먼트의 페이지를, 아니면 NULL을 반환 */
+struct shm_ref *
+shm_page_ref(struct page *page)
+{
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+		return page->uninit.type & VM_SHM ? page->uninit.aux : NULL;
+	case VM_ANON:
+		return page->anon.shm;
+	default:
+		return NULL;
+	}
+}
+
+/* REF의 페이지가 frame에 올라와 있는지 - VM 락을 잡은 상태에서 호출 */
+bool shm_resident(struct shm_ref *ref)
+{
+	return ref->seg->pages[ref->idx].frame != NULL;
+}
+
+/**
+ * @brief 공유 메모리 PAGE를 세그먼트의 올라와 있는 frame에 매핑하는 함수
+ * VM 락을 잡은 상태에서 호출한다. (shm_resident로 확인한 뒤)
+ *
+ * @return false 페이지 테이블을 만들지 못함
+ */
+bool shm_attach(struct page *page)
+{
+	struct shm_ref *ref = shm_page_ref(page);
+	struct frame *frame = ref->seg->pages[ref->idx].frame;
+
+	ASSERT(frame != NULL);
+	if (!pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable))
+		return false;
+	/* 처음 접근하는 페이지면 로드 없이 anon 페이지로 초기화 */
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		page->uninit.page_initializer(page, page->uninit.type, frame->kva);
+
+	/* 매핑이 모두 빠져 세그먼트가 붙잡아 두었던 frame이면 고정을 풂 */
+	bool kept = list_empty(&frame->page_list);
+	list_push_back(&frame->page_list, &page->f_elem);
+	vm_page_set_frame(page, frame);
+	if (kept)
+		vm_frame_unpin(frame);
+	shm_attach_cnt++;
+	return true;
+}
+
+/**
+ * @brief 새 frame(KVA)에 공유 메모리 PAGE의 내용을 채우는 함수 - VM 락을 잡은 상태에서 호출한다.
+ * 내용은 세그먼트의 스왑 슬롯에서 읽고(없으면 0), 이후 같은 페이지를 매핑하는 프로세스는 이 frame을 쓴다.
+ */
+bool shm_swap_in(struct page *page, void *kva)
+{
+	struct shm_ref *ref = page->anon.shm;
+	struct shm_page *p = &ref->seg->pages[ref->idx];
+
+	ASSERT(p->frame == NULL);
+	if (p->slot != SWAP_NONE && p->slot != SWAP_ZERO)
+		shm_in_cnt++;
+	anon_swap_load(p->slot, kva);
+	p->slot = SWAP_NONE;
+	p->frame = page->frame;
+	return true;
+}
+
+/**
+ * @brief 공유 메모리 frame을 내보내는 함수 - 내용을 세그먼트의 스왑 슬롯에 쓰고 frame을 매핑한 모든 페이지를 뺀다.
+ *
+ * @param page frame을 매핑한 페이지 중 하나
+ * @return false 스왑이 가득 참 - 아무것도 바꾸지 않음
+ */
+bool shm_swap_out(struct page *page)
+{
+	struct shm_ref *ref = page->anon.shm;
+	struct shm_page *p = &ref->seg->pages[ref->idx];
+	struct frame *frame = page->frame;
+	size_t slot;
+
+	/* 다른 프로세스가 이 frame에 매핑하는 것은 VM 락이 막음 */
+	if (!anon_swap_save(frame->kva, &slot))
+		return false;
+	p->slot = slot;
+	p->frame = NULL;
+	shm_out_cnt++;
+
+	/* frame은 evict하는 쪽에서 재사용하므로 해제하지 않음 */
+	while (!list_empty(&frame->page_list))
+	{
+		struct page *q = list_entry(list_front(&frame->page_list), struct page, f_elem);
+		vm_page_set_frame(q, NULL);
+		list_remove(&q->f_elem);
+		pml4_clear_page(q->owner->pml4, q->va);
+	}
+	return true;
+}
+
+/**
+ * @brief 공유 메모리 PAGE를 frame에서 떼어 내는 함수
+ * frame을 매핑한 마지막 페이지인데 세그먼트를 다시 매핑할 수 있으면 내용을 세그먼트의 스왑 슬롯에 남긴다.
+ * 스왑이 가득 차면 frame을 고정해 세그먼트가 붙잡아 둔다.
+ */
+static void
+shm_detach(struct page *page)
+{
+	struct shm_ref *ref = page->anon.shm;
+	struct shm_page *p = &ref->seg->pages[ref->idx];
+	struct frame *frame = page->frame;
+
+	if (frame == NULL)
+		return;
+
+	if (list_size(&frame->page_list) == 1)
+	{
+		size_t slot;
+
+		/* 쓰는 동안 다른 스레드가 frame을 내보내지 않도록 고정 */
+		frame->pin_cnt++;
+		if (!shm_live(ref->seg))
+		{
+			p->frame = NULL;
+			frame->pin_cnt--;
+		}
+		else if (anon_swap_save(frame->kva, &slot))
+		{
+			p->slot = slot;
+			p->frame = NULL;
+			frame->pin_cnt--;
+			shm_out_cnt++;
+		}
+		else
+			shm_keep_cnt++;
+	}
+	vm_frame_unlink(page);
+}
+
+/* madvise(DONTNEED) - 매핑만 내려놓고 내용은 세그먼트에 남김 */
+bool shm_discard(struct page *page)
+{
+	bool dropped = page->frame != NULL;
+
+	shm_detach(page);
+	return dropped;
+}
+
+/* 공유 메모리 페이지를 없앰 - PAGE는 호출자가 해제 */
+void shm_destroy(struct page *page)
+{
+	shm_detach(page);
+	shm_ref_free(page->anon.shm);
+}
+
+/* 페이지의 세그먼트 참조를 놓음 - 처음 폴트가 나기 전에 없어지는 페이지도 호출 */
+void shm_ref_free(struct shm_ref *ref)
+{
+	struct shm_segment *seg = ref->seg;
+
+	free(ref);
+	shm_put(seg);
+}
+
+/* Prints shared memory statistics. */
+void shm_print_stats(void)
+{
+	printf("Shared memory: %lld segments created, %lld faults mapped resident pages, "
+		   "%lld pages out, %lld pages in, %lld kept in memory\n",
+		   shm_create_cnt, shm_attach_cnt, shm_out_cnt, shm_in_cnt, shm_keep_cnt);
+}
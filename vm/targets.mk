@@ -3,3 +3,8 @@ vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
 vm_SRC += vm/inspect.c    # Testing utility
+vm_SRC += vm/zswap.c      # Compressed swap cache
+vm_SRC += vm/ksm.c        # Same-page merging
+vm_SRC += vm/vma.c        # Memory regions
+vm_SRC += vm/thp.c        # Transparent huge pages
+vm_SRC += vm/shm.c        # Shared anonymous memory
@@ -0,0 +1,169 @@
+/* thp.c: Transparent huge pages - maps 2 MB aligned blocks of anonymous regions with a single 2 MB page. */
+
+#include <stdio.h>
+#include "vm/thp.h"
+#include "vm/vm.h"
+#include "vm/vma.h"
+#include "threads/mmu.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* NOTE: [VM] THP - 파일에서 읽을 내용이 없는 쓰기 가능한 anon 구간(bss 등)에서, 구간 안에 완전히 들어가고
+ * 아직 페이지가 하나도 없는 2 MB 블록에 쓰기 폴트가 나면 2 MB로 정렬된 frame 묶음을 얻어 페이지 디렉터리 항목 하나로 매핑한다.
+ * 블록의 폴트 512번이 한 번으로 줄고 TLB 항목도 하나만 쓴다.
+ * 4 kB 페이지 구조체는 모두 만들어 각자의 frame에 연결하므로, 페이지 하나를 내보내거나(swap out) 버리면(madvise DONTNEED)
+ * pml4_clear_page가 2 MB 매핑을 4 kB 페이지 테이블로 나누고 나머지 페이지는 그대로 남는다.
+ * COW는 페이지마다 쓰기 권한을 바꿔야 하므로 fork 전에 부모의 2 MB 매핑을 모두 나눈다. (커널 옵션 -thp) */
+static bool thp_enabled;
+static long long thp_map_cnt;	   /* 2 MB 페이지로 매핑한 폴트 수 */
+static long long thp_fallback_cnt; /* 비어 있는 2 MB frame 묶음이 없어 4 kB 페이지로 처리한 폴트 수 */
+static long long thp_fork_cnt;	   /* fork를 위해 나눈 2 MB 매핑 수 */
+
+/* 커널 옵션 -thp - 큰 anon 구간을 2 MB 페이지로 매핑 */
+void thp_enable(void)
+{
+	thp_enabled = true;
+}
+
+/* BLOCK이 2 MB 페이지로 매핑할 수 있는 블록인지 - 쓰기 가능한 anon 구간 VMA 안에 있고 파일에서 읽을 부분이 없음 */
+static bool
+thp_block_ok(struct vma *vma, uint8_t *block)
+{
+	return vma->type == VM_ANON && vma->writable && vma->start <= block && (size_t)(vma->end - block) >= HUGE_PGSIZE && vma->read_bytes <= (size_t)(block - vma->start);
+}
+
+/* BLOCK에 아직 페이지가 하나도 없는지 */
+static bool
+thp_block_empty(struct supplemental_page_table *spt, uint64_t *pml4, uint8_t *block)
+{
+	/* 매핑된 적이 있는 4 kB 페이지가 있으면 페이지 테이블의 항목 수로 바로 알 수 있음 */
+	uint64_t *pde = pml4_pde_walk(pml4, (uint64_t)block, false);
+	if (pde != NULL && (*pde & PTE_P) && ((*pde & PTE_PS) || PTE_CNT(*pde) > 0))
+		return false;
+
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+		if (spt_find_page(spt, block + i * PGSIZE) != NULL)
+			return false;
+	return true;
+}
+
+/**
+ * @brief ADDR에 쓰기 폴트가 났을 때 ADDR을 포함하는 2 MB 블록 전체를 2 MB 페이지 하나로 매핑하는 함수
+ * 블록의 4 kB 페이지를 모두 만들어 매핑한 뒤 각자의 frame에 연결한다. 연결하기 전의 frame은 eviction 대상이 아니다.
+ *
+ * @param spt 현재 프로세스의 spt
+ * @param addr 폴트가 난 주소
+ * @return true 블록을 매핑함
+ * @return false THP를 쓸 수 없는 주소이거나 2 MB frame 묶음을 얻지 못함 - 호출자가 4 kB 페이지로 처리
+ */
+bool thp_fault(struct supplemental_page_table *spt, void *addr)
+{
+	if (!thp_enabled)
+		return false;
+
+	uint64_t *pml4 = thread_current()->pml4;
+	uint8_t *block = pg_huge_round_down(addr);
+	struct vma *vma = vma_find(spt, addr);
+	if (vma == NULL || !thp_block_ok(vma, block) || !thp_block_empty(spt, pml4, block))
+		return false;
+
+	uint8_t *kva = vm_frame_alloc_huge();
+	if (kva == NULL)
+	{
+		thp_fallback_cnt++;
+		return false;
+	}
+
+	size_t cnt;
+	for (cnt = 0; cnt < HUGE_PGCNT; cnt++)
+	{
+		if (!vm_alloc_page(VM_ANON, block + cnt * PGSIZE, true))
+			break;
+		spt_find_page(spt, block + cnt * PGSIZE)->advice = vma->advice;
+	}
+	if (cnt < HUGE_PGCNT || !pml4_set_huge_page(pml4, block, kva, true))
+	{
+		for (size_t i = 0; i < cnt; i++)
+			spt_remove_page(spt, spt_find_page(spt, block + i * PGSIZE));
+		for (size_t i = 0; i < HUGE_PGCNT; i++)
+			vm_frame_free_unused(kva + i * PGSIZE);
+		thp_fallback_cnt++;
+		return false;
+	}
+
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+		vm_frame_attach(spt_find_page(spt, block + i * PGSIZE), kva + i * PGSIZE);
+	spt->thp_cnt++;
+	thp_map_cnt++;
+	return true;
+}
+
+/**
+ * @brief SPT에서 2 MB 페이지로 매핑되어 있는 블록마다 FUNC를 호출하는 함수
+ *
+ * @return false FUNC가 false를 반환해 중간에 멈춤
+ */
+static bool
+thp_for_each(struct supplemental_page_table *spt, bool (*func)(uint64_t *pml4, uint8_t *block))
+{
+	if (spt->thp_cnt == 0)
+		return true;
+
+	for (struct list_elem *e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e))
+	{
+		/* madvise로 나뉜 구간에 걸친 블록도 있으므로 구간과 겹치는 블록을 모두 봄 */
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->type != VM_ANON)
+			continue;
+		for (uint8_t *block = pg_huge_round_down(vma->start); block < vma->end; block += HUGE_PGSIZE)
+		{
+			struct page *page = spt_find_page(spt, block);
+			if (page == NULL || page->owner->pml4 == NULL || !pml4_is_huge_page(page->owner->pml4, block))
+				continue;
+			if (!func(page->owner->pml4, block))
+				return false;
+		}
+	}
+	return true;
+}
+
+/* 2 MB 매핑을 같은 frame을 가리키는 4 kB 페이지 테이블로 나눔 */
+static bool
+thp_split(uint64_t *pml4, uint8_t *block)
+{
+	if (pml4e_walk(pml4, (uint64_t)block, true) == NULL)
+		return false;
+	thp_fork_cnt++;
+	return true;
+}
+
+/* fork - SPT의 2 MB 매핑을 모두 4 kB 페이지로 나눔. 페이지 테이블을 얻지 못하면 false */
+bool thp_split_all(struct supplemental_page_table *spt)
+{
+	return thp_for_each(spt, thp_split);
+}
+
+/* 2 MB 매핑을 지움 - frame은 해제하지 않음 */
+static bool
+thp_unmap(uint64_t *pml4, uint8_t *block)
+{
+	pml4_clear_huge_page(pml4, block);
+	return true;
+}
+
+/* 프로세스 종료 - 페이지를 지우기 전에 2 MB 매핑을 한 번에 지워, 페이지마다 매핑을 나누지 않게 함 */
+void thp_kill(struct supplemental_page_table *spt)
+{
+	thp_for_each(spt, thp_unmap);
+	spt->thp_cnt = 0;
+}
+
+/* Prints transparent huge page statistics. */
+void thp_print_stats(void)
+{
+	if (!thp_enabled)
+		return;
+
+	printf("THP: %lld faults mapped 2 MB pages, %lld fell back to 4 kB pages, %lld split for fork\n",
+		   thp_map_cnt, thp_fallback_cnt, thp_fork_cnt);
+}
@@ -8,8 +8,11 @@
  * function.
  * */
 
+#include <string.h>
 #include "vm/vm.h"
 #include "vm/uninit.h"
+#include "vm/shm.h"
+#include "threads/vaddr.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
 static void uninit_destroy(struct page *page);
@@ -51,6 +54,10 @@ uninit_initialize(struct page *page, void *kva)
 	vm_initializer *init = uninit->init;
 	void *aux = uninit->aux;
 
+	/* NOTE: [VM] 초기화 함수가 없는 페이지는 0으로 채움 - zero page로 읽던 내용과 같아야 함 */
+	if (init == NULL)
+		memset(kva, 0, PGSIZE);
+
 	/* page_initializer를 함수 포인터로 호출 */
 	/* TODO: You may need to fix this function. */
 	return uninit->page_initializer(page, uninit->type, kva) &&
@@ -70,4 +77,7 @@ uninit_destroy(struct page *page)
 	if (uninit->type == VM_ANON)
 	{
 	}
+	/* NOTE: [VM] 폴트가 나기 전에 없어지는 공유 메모리 페이지는 세그먼트의 참조를 놓음 */
+	if (uninit->type & VM_SHM)
+		shm_ref_free(uninit->aux);
 }
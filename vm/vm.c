@@ -1,23 +1,160 @@
 /* vm.c: Generic interface for virtual memory objects. */
+#include <stdio.h>
 #include <string.h>
+#include <syscall-nr.h>
 #include "threads/malloc.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "vm/ksm.h"
+#include "vm/shm.h"
+#include "vm/thp.h"
+#include "vm/vma.h"
 #include "lib/kernel/hash.h"
 #include "threads/mmu.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
 #include "userprog/syscall.h"
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "userprog/process.h"
 
 static struct frame_table frame_table;
 
+/* NOTE: [VM] VM 락 - vm_lock_acquire 참고 */
+struct lock vm_lock;
+
+/* NOTE: [VM] COW 통계 */
+static long long cow_share_cnt; /* fork 시 frame을 공유한 페이지 수 */
+static long long cow_copy_cnt;	/* 쓰기 폴트에서 새 frame으로 복사한 횟수 */
+static long long cow_reuse_cnt; /* 마지막 공유자가 복사 없이 frame을 가져간 횟수 */
+
+/* NOTE: [VM] text cache - (inode, offset)으로 읽기 전용 실행 파일 페이지를 담은 frame을 찾음 */
+static struct hash text_cache;
+static long long text_hit_cnt;	/* 다른 프로세스의 frame을 공유한 text 페이지 수 */
+static long long text_load_cnt; /* 실행 파일에서 읽어 온 text 페이지 수 */
+
+/* NOTE: [VM] 페이지 교체 정책 - 커널 옵션 -vm=clock|2q 로 선택 */
+static enum vm_policy vm_policy = VM_POLICY_CLOCK;
+
+/* NOTE: [VM] 2Q - 새로 올라온 frame은 cold 큐(FIFO)에, cold 큐에서 쫓겨난 뒤
+ * 곧 다시 폴트가 난 페이지(ghost)의 frame은 hot 큐(clock)에 넣는다.
+ * 한 번 훑고 지나가는 scan은 cold 큐만 돌게 되어 hot 큐의 working set을 밀어내지 않는다. */
+static struct list cold_queue, hot_queue;
+static size_t cold_cnt, hot_cnt;
+static unsigned evict_seq; /* cold 큐에서 쫓겨난 frame 수 - ghost 판별용 */
+
+static long long evict_cnt;		 /* 전체 eviction 수 */
+static long long evict_cold_cnt; /* cold 큐에서의 eviction 수 */
+static long long promote_cnt;	 /* ghost 적중으로 hot 큐에 들어간 수 */
+
+/* NOTE: [VM] zero page - 아직 쓰지 않은 anon 페이지를 읽으면 모든 프로세스가 공유하는 이 페이지를 읽기 전용으로 매핑 */
+static void *zero_page;
+static long long zero_map_cnt;	/* zero page를 매핑한 읽기 폴트 수 */
+static long long zero_fill_cnt; /* zero page에 쓰기가 발생해 frame을 할당한 수 */
+
+static size_t frame_used_cnt; /* 사용 중인 frame 수 */
+static size_t frame_peak_cnt; /* 동시에 사용한 frame 수의 최댓값 */
+
+/* NOTE: [VM] kswapd - 남은 frame이 low watermark 아래로 내려가면 깨어나
+ * high watermark까지 미리 evict해서, 폴트가 난 스레드가 직접 evict하지 않아도 되게 한다. (커널 옵션 -kswapd) */
+#define KSWAPD_LOW_DIV 32  /* low watermark = frame 수 / 32 */
+#define KSWAPD_HIGH_DIV 16 /* high watermark = frame 수 / 16 */
+
+static bool kswapd_enabled;
+static bool kswapd_awake;
+static struct semaphore kswapd_sema;
+static size_t kswapd_low, kswapd_high;
+static long long kswapd_wake_cnt;	 /* kswapd가 깨어난 횟수 */
+static long long kswapd_reclaim_cnt; /* kswapd가 비운 frame 수 */
+static long long direct_reclaim_cnt; /* 폴트가 난 스레드가 직접 evict한 수 */
+
+/* NOTE: [VM] 페이지 폴트 처리 시간 (TSC cycle) 히스토그램 - 2의 거듭제곱 단위 구간 */
+#define FAULT_HIST_CNT 48
+static long long fault_hist[FAULT_HIST_CNT];
+static long long fault_cnt;
+static uint64_t fault_max;
+
+static void vm_kswapd(void *aux);
+
+/* NOTE: [VM] fault-around - 파일에서 읽는 페이지에 폴트가 나면 같은 창(fault_around 페이지로 정렬)에 있는
+ * 같은 파일의 연속된 이웃 페이지도 남는 frame이 있는 만큼 함께 올린다. (커널 옵션 -fault-around=N) */
+#define FAULT_AROUND_MAX 64
+static size_t fault_around = 8;
+static long long file_fault_cnt;   /* 파일 내용을 읽은 폴트 수 */
+static long long fault_around_cnt; /* 폴트 없이 함께 올린 페이지 수 */
+static long long exec_cnt;		   /* 성공한 exec 수 */
+
+/* NOTE: [VM] madvise(SEQUENTIAL) - 폴트가 난 주소에서 DROP_BEHIND_DIST 페이지 뒤부터
+ * 최대 DROP_BEHIND_MAX 페이지를 내려놓거나(깨끗한 file 페이지) 먼저 내보내지도록 accessed 비트를 지운다. */
+#define DROP_BEHIND_DIST 32
+#define DROP_BEHIND_MAX 64
+static long long advise_prefault_cnt; /* madvise(WILLNEED)로 미리 올린 페이지 수 */
+static long long advise_drop_cnt;	  /* madvise(DONTNEED)로 내려놓은 페이지 수 */
+static long long drop_behind_cnt;	  /* 순차 접근에서 지나간 뒤 내려놓은 페이지 수 */
+
+/* NOTE: [VM] overcommit - 쓰기 가능한 anon 구간(데이터, bss)과 스택 페이지는 구간을 만들 때 예약(commit)하고
+ * 프로세스가 끝날 때 돌려준다. 파일 매핑은 내용이 파일로 돌아가므로 예약하지 않는다. (커널 옵션 -overcommit=POLICY) */
+#define OVERCOMMIT_RATIO 50 /* never - 스왑에 더해 예약할 수 있는 frame의 비율 (%) */
+static enum vm_overcommit vm_overcommit = VM_OVERCOMMIT_ALWAYS;
+static size_t commit_total;		  /* 모든 프로세스가 예약한 페이지 수 */
+static size_t commit_peak;		  /* commit_total의 최댓값 */
+static long long commit_fail_cnt; /* 거절한 예약 수 */
+
+/* NOTE: [VM] OOM killer - 스왑이 가득 차 frame을 비울 수 없으면 상주 + 스왑 페이지가 가장 많은 프로세스를 종료시킨다.
+ * 고른 프로세스가 폴트를 낸 프로세스면 폴트가 실패해 바로 종료되고, 다른 프로세스면 다음 폴트나 시스템 콜에서
+ * 종료되도록 표시하고 할당은 실패한다. 폴트는 락을 모두 놓은 뒤 frame이 돌아올 때까지 최대 OOM_WAIT 틱 기다렸다가 다시 시도한다.
+ * 시스템 콜 안에서 잠든 프로세스는 종료하지 못할 수 있으므로 OOM_WAIT가 지나도 남아 있으면 다른 프로세스를 고른다. */
+#define OOM_EVICT_TRIES 4 /* OOM killer를 부르기 전에 다른 frame을 골라 evict해 보는 횟수 */
+#define OOM_WAIT TIMER_FREQ
+static long long oom_kill_cnt; /* OOM killer가 종료시킨 프로세스 수 */
+
+/* NOTE: [VM] 모든 프로세스의 메모리 사용량 합계 - 각 spt의 카운터와 함께 바뀐다. (meminfo) */
+static size_t rss_anon_total; /* frame에 올라와 있는 anon 페이지 수 */
+static size_t rss_file_total; /* frame에 올라와 있는 파일 매핑 페이지 수 */
+static size_t swap_total;	  /* 스왑 슬롯에 있는 anon 페이지 수 */
+static size_t mem_peak;		  /* rss_anon_total + rss_file_total + swap_total의 최댓값 */
+static long long minor_fault_cnt;
+static long long major_fault_cnt;
+
+static uint64_t text_hash(const struct hash_elem *e, void *aux);
+static bool text_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void vm_init(void)
 {
+	lock_init(&vm_lock);
 	vm_anon_init();
 	vm_file_init();
-	/* NOTE: frame table의 frame_list 초기화 */
-	list_init(&frame_table.frame_list);
-	frame_table.curr_frame = list_tail(&frame_table.frame_list);
+	/* NOTE: frame table 초기화 - user pool의 모든 페이지에 대한 frame을 미리 할당 */
+	frame_table.base = palloc_user_pool(&frame_table.frame_cnt);
+	frame_table.frames = calloc(frame_table.frame_cnt, sizeof(struct frame));
+	if (frame_table.frames == NULL)
+		PANIC("frame table allocation failed");
+	for (size_t i = 0; i < frame_table.frame_cnt; i++)
+	{
+		frame_table.frames[i].kva = frame_table.base + i * PGSIZE;
+		list_init(&frame_table.frames[i].page_list);
+	}
+	frame_table.hand = 0;
+	zero_page = palloc_get_page(PAL_ZERO);
+	if (zero_page == NULL)
+		PANIC("zero page allocation failed");
+	list_init(&cold_queue);
+	list_init(&hot_queue);
+	hash_init(&text_cache, text_hash, text_less, NULL);
+	ksm_init();
+	shm_init();
+	if (kswapd_enabled)
+	{
+		kswapd_low = frame_table.frame_cnt / KSWAPD_LOW_DIV + 1;
+		kswapd_high = frame_table.frame_cnt / KSWAPD_HIGH_DIV + 2;
+		sema_init(&kswapd_sema, 0);
+		if (thread_create("kswapd", PRI_DEFAULT, vm_kswapd, NULL) == TID_ERROR)
+			PANIC("cannot start kswapd");
+	}
 #ifdef EFILESYS /* For project 4 */
 	pagecache_init();
 #endif
@@ -26,6 +163,131 @@ void vm_init(void)
 	/* TODO: Your code goes here. */
 }
 
+/**
+ * @brief 페이지 교체 정책을 설정하는 함수 - 커널 옵션 -vm=NAME
+ *
+ * @param name "clock" 또는 "2q"
+ */
+void vm_set_policy(const char *name)
+{
+	if (name != NULL && !strcmp(name, "clock"))
+		vm_policy = VM_POLICY_CLOCK;
+	else if (name != NULL && !strcmp(name, "2q"))
+		vm_policy = VM_POLICY_2Q;
+	else
+		PANIC("unknown page replacement policy `%s'", name != NULL ? name : "");
+}
+
+/* 커널 옵션 -kswapd - 백그라운드 페이지 회수를 켬 */
+void vm_enable_kswapd(void)
+{
+	kswapd_enabled = true;
+}
+
+/* 커널 옵션 -fault-around=N - 폴트 하나에 함께 올릴 창의 크기 (0, 1이면 끔) */
+void vm_set_fault_around(int pages)
+{
+	fault_around = pages < 0 ? 0 : pages > FAULT_AROUND_MAX ? FAULT_AROUND_MAX : pages;
+}
+
+/**
+ * @brief overcommit 정책을 설정하는 함수 - 커널 옵션 -overcommit=NAME
+ *
+ * @param name "always", "heuristic" 또는 "never"
+ */
+void vm_set_overcommit(const char *name)
+{
+	if (name != NULL && !strcmp(name, "always"))
+		vm_overcommit = VM_OVERCOMMIT_ALWAYS;
+	else if (name != NULL && !strcmp(name, "heuristic"))
+		vm_overcommit = VM_OVERCOMMIT_HEURISTIC;
+	else if (name != NULL && !strcmp(name, "never"))
+		vm_overcommit = VM_OVERCOMMIT_NEVER;
+	else
+		PANIC("unknown overcommit policy `%s'", name != NULL ? name : "");
+}
+
+/* never 정책에서 모든 프로세스가 예약할 수 있는 페이지 수 */
+static size_t
+vm_commit_limit(void)
+{
+	return anon_swap_slots() + frame_table.frame_cnt * OVERCOMMIT_RATIO / 100;
+}
+
+/**
+ * @brief SPT의 프로세스가 PAGES개의 쓰기 가능한 anon 페이지를 예약하는 함수
+ *
+ * @param spt
+ * @param pages 예약할 페이지 수
+ * @return true
+ * @return false overcommit 정책이 예약을 거절함
+ */
+bool vm_commit(struct supplemental_page_table *spt, size_t pages)
+{
+	bool ok = true;
+	enum intr_level old_level = intr_disable();
+
+	if (vm_overcommit == VM_OVERCOMMIT_HEURISTIC)
+		ok = pages <= frame_table.frame_cnt + anon_swap_slots();
+	else if (vm_overcommit == VM_OVERCOMMIT_NEVER)
+		ok = commit_total + pages <= vm_commit_limit();
+
+	if (ok)
+	{
+		commit_total += pages;
+		spt->commit_cnt += pages;
+		if (commit_total > commit_peak)
+			commit_peak = commit_total;
+	}
+	else
+		commit_fail_cnt++;
+	intr_set_level(old_level);
+	return ok;
+}
+
+/* vm_commit으로 예약한 PAGES개의 페이지를 돌려줌 */
+void vm_uncommit(struct supplemental_page_table *spt, size_t pages)
+{
+	enum intr_level old_level = intr_disable();
+
+	ASSERT(spt->commit_cnt >= pages);
+	commit_total -= pages;
+	spt->commit_cnt -= pages;
+	intr_set_level(old_level);
+}
+
+/**
+ * @brief VM 락을 잡는 함수 - 이미 잡고 있으면 그대로 둔다.
+ * frame table, 2Q 큐와 clock hand, 스왑 슬롯, frame의 page_list, 페이지 해제는 모두 이 락 아래에서 바꾼다.
+ * 락 순서는 VM 락 → filesys_lock이다. eviction과 로드는 VM 락을 잡은 채 파일을 읽고 쓰므로
+ * filesys_lock을 잡은 채로는 VM 락을 잡거나 사용자 메모리에 접근(폴트)하지 않는다.
+ * (시스템 콜은 사용자 버퍼를 커널 버퍼로 옮긴 뒤 filesys_lock을 잡는다)
+ *
+ * @return true 새로 잡음 - vm_lock_release로 놓아야 함
+ * @return false 이미 잡고 있었음
+ */
+bool vm_lock_acquire(void)
+{
+	if (lock_held_by_current_thread(&vm_lock))
+		return false;
+	ASSERT(!lock_held_by_current_thread(&filesys_lock));
+	lock_acquire(&vm_lock);
+	return true;
+}
+
+/* vm_lock_acquire가 새로 잡은 락이면 놓음 */
+void vm_lock_release(bool locked)
+{
+	if (locked)
+		lock_release(&vm_lock);
+}
+
+/* exec로 새 실행 파일을 올렸음을 기록 - exec 당 폴트 수 통계 */
+void vm_exec_loaded(void)
+{
+	exec_cnt++;
+}
+
 /* Get the type of the page. This function is useful if you want to know the
  * type of the page after it will be initialized.
  * This function is fully implemented now. */
@@ -42,10 +304,127 @@ page_get_type(struct page *page)
 	}
 }
 
+/**
+ * @brief text cache의 hash 함수 - 실행 파일의 inode와 offset으로 hash
+ */
+static uint64_t
+text_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame *f = hash_entry(e, struct frame, text_elem);
+	return hash_bytes(&f->text_inode, sizeof f->text_inode) ^ hash_int(f->text_ofs);
+}
+
+static bool
+text_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED)
+{
+	const struct frame *a = hash_entry(a_, struct frame, text_elem);
+	const struct frame *b = hash_entry(b_, struct frame, text_elem);
+
+	if (a->text_inode != b->text_inode)
+		return a->text_inode < b->text_inode;
+	return a->text_ofs < b->text_ofs;
+}
+
+/**
+ * @brief 실행 파일 INODE의 OFS 위치를 담고 있는 frame을 text cache에서 찾는 함수
+ * 없으면 NULL을 반환
+ */
+static struct frame *
+text_cache_find(struct inode *inode, off_t ofs)
+{
+	struct frame key;
+	struct hash_elem *e;
+
+	key.text_inode = inode;
+	key.text_ofs = ofs;
+	e = hash_find(&text_cache, &key.text_elem);
+	return e != NULL ? hash_entry(e, struct frame, text_elem) : NULL;
+}
+
+/**
+ * @brief 실행 파일에서 읽어 온 frame을 text cache에 등록하는 함수
+ * inode가 frame보다 먼저 닫히지 않도록 참조를 하나 잡아 둔다.
+ */
+static void
+text_cache_insert(struct frame *frame, struct page_load_info *info)
+{
+	frame->text_inode = file_get_inode(info->file);
+	frame->text_ofs = info->offset;
+	/* 디스크에서 읽는 동안 다른 프로세스가 먼저 등록했다면 이 frame은 등록하지 않음 */
+	if (hash_insert(&text_cache, &frame->text_elem) != NULL)
+	{
+		frame->text_inode = NULL;
+		return;
+	}
+	inode_reopen(frame->text_inode);
+}
+
+/* frame이 text cache에 있으면 제거 */
+static void
+text_cache_remove(struct frame *frame)
+{
+	if (frame->text_inode == NULL)
+		return;
+	hash_delete(&text_cache, &frame->text_elem);
+	inode_close(frame->text_inode);
+	frame->text_inode = NULL;
+}
+
+/* 페이지가 text 페이지이면 로드 정보를, 아니면 NULL을 반환 */
+static struct page_load_info *
+vm_text_info(struct page *page)
+{
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+		return page->uninit.type & VM_TEXT ? page->uninit.aux : NULL;
+	case VM_ANON:
+		return page->anon.text;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * @brief text 페이지를 이미 메모리에 있는 frame에 매핑하는 함수
+ * 같은 실행 파일을 실행 중인 다른 프로세스가 같은 위치를 올려 두었다면 디스크에서 읽지 않고 frame을 공유한다.
+ *
+ * @param page 매핑할 text 페이지
+ * @param info 페이지의 로드 정보
+ * @return true 공유에 성공
+ * @return false cache에 없음 - 호출자가 새 frame에 로드해야 함
+ */
+static bool
+vm_share_text_page(struct page *page, struct page_load_info *info)
+{
+	struct frame *frame = text_cache_find(file_get_inode(info->file), info->offset);
+	if (frame == NULL)
+		return false;
+
+	if (!pml4_set_page(thread_current()->pml4, page->va, frame->kva, false))
+		return false;
+	/* 처음 접근하는 페이지면 로드 없이 anon 페이지로 초기화 */
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		page->uninit.page_initializer(page, page->uninit.type, frame->kva);
+	list_push_back(&frame->page_list, &page->f_elem);
+	vm_page_set_frame(page, frame);
+	text_hit_cnt++;
+	return true;
+}
+
 /* Helpers */
 static struct frame *vm_get_victim(void);
 static bool vm_do_claim_page(struct page *page);
+static bool vm_spt_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src);
+static bool vm_handle_fault(struct intr_frame *f, void *addr, bool user, bool write, bool not_present, bool locked);
 static struct frame *vm_evict_frame(void);
+static void vm_free_frame(struct frame *frame);
+static void vm_release_frame(struct frame *frame);
+static void vm_frame_reset(struct frame *frame);
+static size_t vm_free_frame_cnt(void);
+static bool vm_zero_unmap(struct page *page);
+static bool vm_install_frame(struct page *page, struct frame *frame,
+							 struct page_load_info *text);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -81,6 +460,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 
 		page->writable = writable;		/* page에 쓰기 가능 여부 설정 */
 		page->owner = thread_current(); /* page owner thread 설정 */
+		page->evict_seq = 0;
 		/* 현재 프로세스의 보조 페이지 테이블에 생성한 페이지 추가 */
 		if (!spt_insert_page(&thread_current()->spt, page))
 		{
@@ -136,6 +516,7 @@ void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
 	/* NOTE: [VM] spt의 hash에서 해당 페이지 삭제 */
 	hash_delete(&spt->hash, &page->hash_elem);
+	vm_zero_unmap(page);
 	vm_dealloc_page(page);
 	return true;
 }
@@ -148,38 +529,141 @@ static bool vm_find_victim(struct frame *frame)
 		struct page *page = list_entry(pe, struct page, f_elem);
 		if (pml4_is_accessed(page->owner->pml4, page->va))
 		{
+			/* NOTE: [VM] 미리 읽어 둔 페이지가 쓰였음을 readahead에 알림 */
+			if (VM_TYPE(page->operations->type) == VM_ANON)
+				anon_readahead_check(page, true);
+			else if (VM_TYPE(page->operations->type) == VM_FILE)
+				file_ra_check(page, true);
 			pml4_set_accessed(page->owner->pml4, page->va, 0);
+			frame->age = 0;
 			is_victim = false;
 		}
 		uint64_t *pte = pml4e_walk(page->owner->pml4, page->va, 0);
 		if (is_kern_pte(pte))
 			is_victim = false;
 	}
+	/* NOTE: [VM] COW 복사 중이거나 아직 페이지를 연결하기 전인 frame은 eviction 대상에서 제외 */
+	if (frame->pin_cnt > 0 || list_empty(&frame->page_list))
+		is_victim = false;
+	if (!is_victim && frame->age < UINT8_MAX)
+		frame->age++;
 	return is_victim;
 }
 
+/**
+ * @brief 2Q - PAGE가 올라온 FRAME을 cold 또는 hot 큐에 넣는 함수
+ * 최근에 cold 큐에서 쫓겨난 페이지(ghost)가 다시 폴트난 것이면 hot 큐에, 아니면 cold 큐에 넣는다.
+ */
+static void
+vm_queue_insert(struct frame *frame, struct page *page)
+{
+	if (vm_policy != VM_POLICY_2Q)
+		return;
+
+	/* ghost 기간: 그 뒤로 cold 큐에서 쫓겨난 frame이 전체의 절반보다 적을 때 */
+	if (page->evict_seq != 0 && evict_seq - page->evict_seq < frame_table.frame_cnt / 2)
+	{
+		frame->flags |= FRAME_HOT;
+		list_push_back(&hot_queue, &frame->q_elem);
+		hot_cnt++;
+		promote_cnt++;
+	}
+	else
+	{
+		list_push_back(&cold_queue, &frame->q_elem);
+		cold_cnt++;
+	}
+}
+
+/* 2Q - FRAME을 큐에서 제거 */
+static void
+vm_queue_remove(struct frame *frame)
+{
+	if (vm_policy != VM_POLICY_2Q)
+		return;
+
+	list_remove(&frame->q_elem);
+	if (frame->flags & FRAME_HOT)
+		hot_cnt--;
+	else
+		cold_cnt--;
+	frame->flags &= ~FRAME_HOT;
+}
+
+/* 2Q - frame을 쫓아내도 되는지 (pin 또는 커널 매핑이 아닌지) */
+static bool
+vm_frame_evictable(struct frame *frame)
+{
+	if (frame->pin_cnt > 0)
+		return false;
+	for (struct list_elem *pe = list_begin(&frame->page_list); pe != list_end(&frame->page_list); pe = list_next(pe))
+	{
+		struct page *page = list_entry(pe, struct page, f_elem);
+		if (is_kern_pte(pml4e_walk(page->owner->pml4, (uint64_t)page->va, 0)))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief 2Q 정책으로 쫓아낼 frame을 고르는 함수
+ * cold 큐가 전체의 1/4보다 크면 cold 큐 앞에서(FIFO), 아니면 hot 큐를 clock으로 돌며 고른다.
+ * 고를 수 없으면 NULL을 반환
+ */
+static struct frame *
+vm_get_victim_2q(void)
+{
+	if (cold_cnt > (cold_cnt + hot_cnt) / 4 || hot_cnt == 0)
+	{
+		for (struct list_elem *e = list_begin(&cold_queue); e != list_end(&cold_queue); e = list_next(e))
+		{
+			struct frame *frame = list_entry(e, struct frame, q_elem);
+			if (vm_frame_evictable(frame))
+				return frame;
+		}
+	}
+
+	/* hot 큐: 접근된 frame은 accessed 비트를 지우고 뒤로 보냄 */
+	for (size_t i = 0; i < 2 * hot_cnt; i++)
+	{
+		struct frame *frame = list_entry(list_pop_front(&hot_queue), struct frame, q_elem);
+		list_push_back(&hot_queue, &frame->q_elem);
+		if (vm_find_victim(frame))
+			return frame;
+	}
+	return NULL;
+}
+
 /* Get the struct frame, that will be evicted. */
 static struct frame *
 vm_get_victim(void)
 {
 	/* NOTE: The policy for eviction is up to you. */
-	struct list_elem *start_elem = frame_table.curr_frame;
-	for (struct list_elem *e = start_elem; e != list_end(&frame_table.frame_list); e = list_next(e))
+	if (vm_policy == VM_POLICY_2Q)
 	{
-		// frame의 page list 순회하며 accessed 확인
-		struct frame *frame = list_entry(e, struct frame, ft_elem);
+		struct frame *victim = vm_get_victim_2q();
+		if (victim != NULL)
+			return victim;
+	}
 
-		if (vm_find_victim(frame))
+	/* NOTE: [VM] clock - hand부터 frame 배열을 두 바퀴 돌며 accessed 확인 */
+	for (size_t i = 0; i < 2 * frame_table.frame_cnt; i++)
+	{
+		struct frame *frame = &frame_table.frames[frame_table.hand];
+		frame_table.hand = (frame_table.hand + 1) % frame_table.frame_cnt;
+
+		// frame의 page list 순회하며 accessed 확인
+		if ((frame->flags & FRAME_USED) && vm_find_victim(frame))
 			return frame;
 	}
-	for (struct list_elem *e = list_begin(&frame_table.frame_list); e != list_end(&frame_table.frame_list); e = list_next(e))
+	for (size_t i = 0; i < frame_table.frame_cnt; i++)
 	{
-		// frame의 page list 순회하며 accessed 확인
-		struct frame *frame = list_entry(e, struct frame, ft_elem);
-		if (vm_find_victim(frame))
+		struct frame *frame = &frame_table.frames[i];
+		if ((frame->flags & FRAME_USED) && frame->pin_cnt == 0 && !list_empty(&frame->page_list))
 			return frame;
 	}
-	return list_entry(list_begin(&frame_table.frame_list), struct frame, ft_elem);
+	/* NOTE: [VM] 모든 frame이 고정되어 있음 - 호출자가 OOM으로 처리 */
+	return NULL;
 }
 
 /* Evict one page and return the corresponding frame.
@@ -187,53 +671,249 @@ vm_get_victim(void)
 static struct frame *
 vm_evict_frame(void)
 {
+	ASSERT(lock_held_by_current_thread(&vm_lock));
+
+	/* NOTE: [VM] 고른 frame을 고정하기 전에 ksmd가 옮기거나 해제하지 않도록 인터럽트를 끈 채 고르고 고정
+	 * 디스크에 쓰는 동안에도 kswapd 등 다른 스레드가 같은 frame을 고르지 않는다. */
+	enum intr_level old_level = intr_disable();
 	struct frame *victim = vm_get_victim();
+	if (victim != NULL)
+		victim->pin_cnt++;
+	intr_set_level(old_level);
 	/* TODO: swap out the victim and return the evicted frame. */
+	if (victim == NULL)
+		return NULL;
 
-	/* clock pointer 위치 갱신 */
-	frame_table.curr_frame = list_next(&victim->ft_elem);
-
+	/* NOTE: [VM] 2Q - cold 큐에서 쫓겨나는 페이지는 ghost로 기록 */
+	unsigned seq = 0;
+	if (vm_policy == VM_POLICY_2Q && !(victim->flags & FRAME_HOT))
+	{
+		seq = evict_seq + 1;
+		if (seq == 0)
+			seq = 1;
+	}
 	for (struct list_elem *pe = list_begin(&victim->page_list); pe != list_end(&victim->page_list); pe = list_next(pe))
+		list_entry(pe, struct page, f_elem)->evict_seq = seq;
+
+	/* NOTE: [VM] COW로 공유 중인 frame이면 모든 페이지를 내보냄
+	 * swap_out이 page를 page_list에서 제거한다.
+	 * 첫 페이지를 내보내지 못하면 (스왑이 가득 참) frame은 그대로 두고 실패 */
+	struct page *first = list_entry(list_front(&victim->page_list), struct page, f_elem);
+	if (!swap_out(first))
 	{
-		struct page *page = list_entry(pe, struct page, f_elem);
+		for (struct list_elem *pe = list_begin(&victim->page_list); pe != list_end(&victim->page_list); pe = list_next(pe))
+			list_entry(pe, struct page, f_elem)->evict_seq = 0;
+		victim->pin_cnt--;
+		return NULL;
+	}
+	vm_page_set_frame(first, NULL);
+	while (!list_empty(&victim->page_list))
+	{
+		struct page *page = list_entry(list_front(&victim->page_list), struct page, f_elem);
 		swap_out(page);
-		page->frame = NULL;
+		vm_page_set_frame(page, NULL);
+	}
+	victim->pin_cnt--;
+
+	if (seq != 0)
+	{
+		evict_seq = seq;
+		evict_cold_cnt++;
 	}
-	list_remove(&victim->ft_elem);
+	text_cache_remove(victim);
+	ksm_forget(victim);
+	vm_queue_remove(victim);
+	evict_cnt++;
 
 	return victim;
 }
 
+/* OOM killer가 고른 프로세스 */
+struct oom_pick
+{
+	struct thread *victim;	/* 상주 + 스왑 페이지가 가장 많은 프로세스 */
+	size_t pages;			/* victim의 상주 + 스왑 페이지 수 */
+	struct thread *pending; /* 고른 지 OOM_WAIT가 지나지 않았고 아직 종료하지 않은 프로세스 */
+};
+
+/* thread_foreach - 사용자 프로세스 T의 메모리 사용량을 PICK과 비교 */
+static void
+vm_oom_score(struct thread *t, void *pick_)
+{
+	struct oom_pick *pick = pick_;
+
+	if (t->pml4 == NULL || t->status == THREAD_DYING)
+		return;
+	/* 이미 고른 프로세스는 기다리고, 기다려도 종료하지 않은 프로세스는 다시 고르지 않음 */
+	if (t->oom_killed)
+	{
+		if (timer_elapsed(t->oom_kill_tick) < OOM_WAIT)
+			pick->pending = t;
+		return;
+	}
+	size_t pages = t->spt.rss_anon_cnt + t->spt.rss_file_cnt + t->spt.swap_cnt;
+	if (pick->victim == NULL || pages > pick->pages)
+	{
+		pick->victim = t;
+		pick->pages = pages;
+	}
+}
+
+/**
+ * @brief OOM killer - frame을 비울 수 없을 때 메모리를 가장 많이 쓰는 프로세스를 종료시키는 함수
+ * 먼저 고른 프로세스가 OOM_WAIT 안에 종료하지 않았으면 새로 고르지 않고 그 프로세스를 기다린다.
+ * 호출자가 잡은 락을 놓을 수 없으므로 여기서 기다리지 않는다. 희생자가 다른 프로세스면 oom_wait를 표시해
+ * 폴트가 락을 놓은 뒤 vm_oom_wait로 기다리게 한다.
+ */
+static void
+vm_oom_kill(void)
+{
+	struct oom_pick pick = {NULL, 0, NULL};
+
+	enum intr_level old_level = intr_disable();
+	thread_foreach(vm_oom_score, &pick);
+	struct thread *victim = pick.pending != NULL ? pick.pending : pick.victim;
+	if (victim != NULL && !victim->oom_killed)
+	{
+		victim->oom_killed = true;
+		victim->oom_kill_tick = timer_ticks();
+		oom_kill_cnt++;
+	}
+	intr_set_level(old_level);
+
+	/* 폴트를 낸 프로세스가 희생자면 폴트가 실패해 종료됨 */
+	if (victim != NULL && victim != thread_current())
+		thread_current()->oom_wait = true;
+}
+
+/**
+ * @brief OOM killer가 고른 다른 프로세스가 종료하며 frame을 돌려주길 최대 OOM_WAIT 틱 기다리는 함수
+ * 락을 하나도 잡지 않은 상태에서 호출한다.
+ *
+ * @return true 할당이 OOM으로 실패했고 그 사이 frame이 돌아옴 - 다시 시도
+ * @return false
+ */
+static bool
+vm_oom_wait(void)
+{
+	struct thread *curr = thread_current();
+
+	if (!curr->oom_wait)
+		return false;
+	curr->oom_wait = false;
+	for (int64_t start = timer_ticks(); timer_elapsed(start) < OOM_WAIT;)
+	{
+		timer_sleep(1);
+		if (vm_free_frame_cnt() > 0)
+			return true;
+	}
+	return false;
+}
+
 /**
  * @brief palloc()을 호출하여 프레임을 가져오는 함수
  * 사용 가능한 프레임이 없다면, 페이지를 프레임에서 추방(evict)하고 해당 프레임을 반환합니다.
- * 항상 유효한 주소를 반환해야 합니다.
+ * 스왑이 가득 차 프레임을 비울 수 없으면 NULL을 반환합니다.
  *
  * @return struct frame*
  */
 static struct frame *
 vm_get_frame(void)
 {
-	struct frame *frame = malloc(sizeof(struct frame));
-	list_init(&frame->page_list);
+	struct frame *frame;
 
 	/* NOTE: [VM] 모든 유저 페이지를 위한 프레임은 PAL_USER을 통해 할당해야 함 */
-	frame->kva = palloc_get_page(PAL_USER);
+	void *kva = palloc_get_page(PAL_USER);
 
 	/* NOTE: 페이지 할당 실패 시 swap out 구현 */
-	if (frame->kva == NULL)
+	if (kva == NULL)
+	{
+		/* NOTE: [VM] 스왑이 가득 차 다른 frame을 골라도 비울 수 없으면 OOM killer */
+		frame = NULL;
+		for (int i = 0; i < OOM_EVICT_TRIES && frame == NULL; i++)
+			frame = vm_evict_frame();
+		if (frame != NULL)
+			direct_reclaim_cnt++;
+		else
+		{
+			vm_oom_kill();
+			return NULL;
+		}
+	}
+	else
+	{
+		/* NOTE: [VM] frame은 미리 할당된 배열에서 페이지 번호로 찾음 - 할당 없음 */
+		frame = &frame_table.frames[pg_no(kva) - pg_no(frame_table.base)];
+		ASSERT(frame->flags == 0);
+	}
+	vm_frame_reset(frame);
+
+	/* NOTE: [VM] 남은 frame이 low watermark 아래면 kswapd를 깨움 */
+	if (kswapd_enabled && !kswapd_awake && vm_free_frame_cnt() < kswapd_low)
+	{
+		kswapd_awake = true;
+		sema_up(&kswapd_sema);
+	}
+	return frame;
+}
+
+/**
+ * @brief kswapd - 깨어날 때마다 남은 frame이 high watermark에 이를 때까지 evict해서 돌려주는 스레드
+ * 더티 file 페이지는 파일에 쓰고 anon 페이지는 스왑으로 내보낸다. (각 페이지의 swap_out)
+ */
+static void
+vm_kswapd(void *aux UNUSED)
+{
+	for (;;)
 	{
-		frame = vm_evict_frame();
+		sema_down(&kswapd_sema);
+		kswapd_wake_cnt++;
+		while (vm_free_frame_cnt() < kswapd_high)
+		{
+			/* frame 하나를 비울 때마다 락을 놓아 폴트가 오래 기다리지 않게 함 */
+			bool locked = vm_lock_acquire();
+			struct frame *frame = vm_evict_frame();
+			if (frame != NULL)
+			{
+				vm_release_frame(frame);
+				kswapd_reclaim_cnt++;
+			}
+			vm_lock_release(locked);
+			if (frame == NULL)
+				break;
+		}
+		kswapd_awake = false;
 	}
+}
 
-	/* NOTE: swap in 시 frame table에 추가 및 curr_frame 갱신 */
-	list_push_back(&frame_table.frame_list, &frame->ft_elem);
+/**
+ * @brief 남은 frame 수 - kswapd watermark와 OOM 대기가 읽는 값
+ * idle 스레드가 미리 0으로 채워 palloc의 zero list에 둔 페이지도 남은 frame으로 센다.
+ * 이 페이지는 비트맵에는 사용 중으로 표시되지만 frame_used_cnt에는 들어가지 않고,
+ * 비트맵이 비면 palloc_get_page가 zero list에서 꺼내 주므로 evict 없이 얻을 수 있다.
+ *
+ * @return size_t
+ */
+static size_t
+vm_free_frame_cnt(void)
+{
+	return frame_table.frame_cnt - frame_used_cnt;
+}
 
-	/* NOTE: frame의 page_list 초기화 */
+/* 새로 사용할 FRAME의 상태를 초기화 */
+static void
+vm_frame_reset(struct frame *frame)
+{
 	ASSERT(frame != NULL);
 	ASSERT(list_empty(&frame->page_list));
 
-	return frame;
+	/* evict한 frame은 이미 사용 중으로 세어져 있음 */
+	if (!(frame->flags & FRAME_USED) && ++frame_used_cnt > frame_peak_cnt)
+		frame_peak_cnt = frame_used_cnt;
+	frame->flags = FRAME_USED;
+	frame->pin_cnt = 0;
+	frame->age = 0;
+	frame->text_inode = NULL;
 }
 
 /* Growing the stack. */
@@ -246,27 +926,484 @@ vm_stack_growth(void *addr)
 	 * - 페이지를 할당할 때는 주소를 페이지 경계로 내림해야 한다.
 	 * - 스택 크기 최대 1MB로 제한해야 한다.
 	 */
-	vm_alloc_page(VM_ANON | VM_MARKER_0, pg_round_down(addr), true);
-}
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	void *upage = pg_round_down(addr);
 
-/* Handle the fault on write_protected page */
-static bool
-vm_handle_wp(struct page *page UNUSED)
-{
+	/* NOTE: [VM] 새 스택 페이지는 예약한 뒤 만듦 */
+	if (spt_find_page(spt, upage) != NULL || !vm_commit(spt, 1))
+		return;
+	if (!vm_alloc_page(VM_ANON | VM_MARKER_0, upage, true))
+		vm_uncommit(spt, 1);
 }
 
 /**
- * @brief GITBOOK
- * TODO: [VM] vm_try_handle_fault 함수 수정
+ * @brief frame을 frame table에서 제거하고 물리 페이지와 함께 해제하는 함수
  *
- * vm_try_handle_fault 함수를 수정하여 spt_find_page를 통해 페이지 폴트 주소에 해당하는 페이지 구조체를 찾아야 한다.
+ * @param frame 해제할 frame (page_list가 비어 있어야 함)
  */
-/* Return true on success */
-bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr,
-						 bool user UNUSED, bool write, bool not_present)
+static void
+vm_free_frame(struct frame *frame)
+{
+	ASSERT(list_empty(&frame->page_list));
+
+	text_cache_remove(frame);
+	ksm_forget(frame);
+	vm_queue_remove(frame);
+	vm_release_frame(frame);
+}
+
+/* 이미 큐와 cache에서 빠진 FRAME의 물리 페이지를 user pool에 돌려줌 */
+static void
+vm_release_frame(struct frame *frame)
+{
+	frame->flags = 0;
+	frame_used_cnt--;
+	palloc_free_page(frame->kva);
+}
+
+/**
+ * @brief 커널 가상 주소 KVA에 해당하는 frame을 찾는 함수
+ * user pool의 페이지가 아니거나 사용 중인 frame이 아니면 NULL을 반환
+ *
+ * @param kva
+ * @return struct frame*
+ */
+struct frame *
+vm_frame_lookup(void *kva)
+{
+	size_t idx = pg_no(kva) - pg_no(frame_table.base);
+	if ((uint8_t *)kva < frame_table.base || idx >= frame_table.frame_cnt)
+		return NULL;
+	struct frame *frame = &frame_table.frames[idx];
+	return frame->flags & FRAME_USED ? frame : NULL;
+}
+
+/* frame table의 IDX번째 frame */
+struct frame *
+vm_frame_at(size_t idx)
+{
+	ASSERT(idx < frame_table.frame_cnt);
+	return &frame_table.frames[idx];
+}
+
+/* frame table의 frame 수 (= user pool의 페이지 수) */
+size_t vm_frame_cnt(void)
+{
+	return frame_table.frame_cnt;
+}
+
+/**
+ * @brief 페이지를 같은 내용을 담은 다른 FRAME으로 옮겨 읽기 전용으로 매핑하는 함수 (KSM 병합)
+ * 원래 frame을 쓰던 마지막 페이지였다면 원래 frame은 해제한다.
+ *
+ * @param page 옮길 페이지
+ * @param frame 같은 내용을 담은 frame
+ * @return true
+ * @return false 매핑 실패 - 페이지는 원래 frame에 그대로 있음
+ */
+bool vm_frame_move(struct page *page, struct frame *frame)
+{
+	struct frame *old = page->frame;
+	uint64_t *pml4 = page->owner->pml4;
+
+	/* 기존 매핑을 지워 TLB에 남은 원래 frame의 항목도 무효화 - 페이지 테이블은 남아 있으므로 다시 매핑할 수 있음 */
+	pml4_clear_page(pml4, page->va);
+	if (!pml4_set_page(pml4, page->va, frame->kva, false))
+	{
+		pml4_set_page(pml4, page->va, old->kva, true);
+		return false;
+	}
+	list_remove(&page->f_elem);
+	list_push_back(&frame->page_list, &page->f_elem);
+	vm_page_set_frame(page, frame);
+
+	if (list_empty(&old->page_list) && old->pin_cnt == 0)
+		vm_free_frame(old);
+	return true;
+}
+
+/* 디버깅용 - 사용 중인 모든 frame의 상태를 출력 */
+void vm_dump_frames(void)
+{
+	printf("frame table: %zu frames at %p, clock hand %zu\n",
+		   frame_table.frame_cnt, frame_table.base, frame_table.hand);
+	for (size_t i = 0; i < frame_table.frame_cnt; i++)
+	{
+		struct frame *frame = &frame_table.frames[i];
+		if (!(frame->flags & FRAME_USED))
+			continue;
+		printf("  %5zu %p: %zu pages, pin %d, age %u%s\n",
+			   i, frame->kva, list_size(&frame->page_list), frame->pin_cnt,
+			   frame->age, frame->text_inode != NULL ? ", text" : "");
+	}
+}
+
+/**
+ * @brief page를 frame에서 분리하는 함수
+ * page의 매핑을 pml4에서 제거하고, frame을 공유하는 마지막 페이지였다면 frame도 해제한다.
+ * fork 이후 frame은 여러 프로세스가 공유할 수 있으므로 frame의 해제는 pml4_destroy가 아닌 VM이 담당한다.
+ *
+ * @param page 분리할 페이지
+ */
+void vm_frame_unlink(struct page *page)
+{
+	struct frame *frame = page->frame;
+	if (frame == NULL)
+		return;
+
+	if (page->owner->pml4 != NULL)
+		pml4_clear_page(page->owner->pml4, page->va);
+	list_remove(&page->f_elem);
+	vm_page_set_frame(page, NULL);
+
+	if (list_empty(&frame->page_list) && frame->pin_cnt == 0)
+		vm_free_frame(frame);
+}
+
+/* FRAME의 고정을 하나 풂 - 고정이 모두 풀렸는데 매핑한 페이지가 없으면 frame을 해제 */
+void vm_frame_unpin(struct frame *frame)
+{
+	ASSERT(frame->pin_cnt > 0);
+
+	if (--frame->pin_cnt == 0 && list_empty(&frame->page_list))
+		vm_free_frame(frame);
+}
+
+/**
+ * @brief COW - 읽기 전용으로 공유 중인 페이지에 쓰기가 발생했을 때 호출되는 함수
+ * 다른 페이지와 frame을 공유 중이면 새 frame에 내용을 복사해 쓰기 가능하게 매핑하고,
+ * 혼자 남은 페이지라면 복사 없이 기존 frame을 쓰기 가능하게 바꾼다.
+ *
+ * @param page 쓰기 폴트가 발생한 페이지
+ * @return true
+ * @return false
+ */
+static bool
+vm_handle_wp(struct page *page)
+{
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = page->owner->pml4;
+
+	/* NOTE: [VM] KSM으로 병합된 frame이면 이 페이지의 병합을 풂 */
+	if (frame->flags & FRAME_KSM)
+		ksm_unmerge(frame, list_size(&frame->page_list) == 1);
+
+	/* 마지막 공유자: 복사 없이 frame을 그대로 사용 */
+	if (list_size(&frame->page_list) == 1)
+	{
+		pml4_set_writable(pml4, page->va, true);
+		cow_reuse_cnt++;
+		return true;
+	}
+
+	/* 새 frame을 얻는 동안 원본 frame이 evict되지 않도록 고정 */
+	frame->pin_cnt++;
+	struct frame *copy = vm_get_frame();
+	frame->pin_cnt--;
+	if (copy == NULL)
+		return false;
+	memcpy(copy->kva, frame->kva, PGSIZE);
+
+	list_remove(&page->f_elem);
+	list_push_back(&copy->page_list, &page->f_elem);
+	vm_page_set_frame(page, copy);
+	vm_queue_insert(copy, page);
+	/* eviction 도중 다른 공유자가 모두 사라졌다면 원본 frame 해제 */
+	if (list_empty(&frame->page_list))
+		vm_free_frame(frame);
+
+	pml4_clear_page(pml4, page->va);
+	cow_copy_cnt++;
+	return pml4_set_page(pml4, page->va, copy->kva, true);
+}
+
+/**
+ * @brief 아직 frame이 없고 내용이 모두 0인 anon 페이지인지 확인하는 함수
+ * 스택 / 힙처럼 초기화 함수가 없는 페이지, 실행 파일에서 읽을 내용이 없는 bss 페이지,
+ * 모두 0이라서 스왑에 쓰지 않고 내보낸 페이지가 해당한다.
+ *
+ * @param page
+ * @return true 읽기만 한다면 zero page를 매핑해도 되는 페이지
+ * @return false
+ */
+static bool
+vm_page_is_zero(struct page *page)
+{
+	if (page->frame != NULL)
+		return false;
+
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+	{
+		struct uninit_page *uninit = &page->uninit;
+		if (VM_TYPE(uninit->type) != VM_ANON || uninit->type & VM_TEXT)
+			return false;
+		if (uninit->init == NULL)
+			return true;
+		return uninit->init == lazy_load_segment && ((struct page_load_info *)uninit->aux)->read_bytes == 0;
+	}
+	return VM_TYPE(page->operations->type) == VM_ANON && page->anon.swap_table_idx == SWAP_ZERO;
+}
+
+/* PAGE에 zero page가 매핑되어 있으면 매핑을 제거 - 제거했으면 true */
+static bool
+vm_zero_unmap(struct page *page)
+{
+	uint64_t *pml4 = page->owner->pml4;
+
+	if (page->frame != NULL || pml4 == NULL || pml4_get_page(pml4, page->va) != zero_page)
+		return false;
+	pml4_clear_page(pml4, page->va);
+	return true;
+}
+
+/**
+ * @brief 페이지의 내용을 읽어 올 파일 위치를 구하는 함수
+ *
+ * @param page
+ * @param inode 파일의 inode
+ * @param ofs 파일 내 offset
+ * @return true
+ * @return false 파일에서 읽는 페이지가 아님 (스왑된 anon 페이지, bss 등)
+ */
+static bool
+vm_file_pos(struct page *page, struct inode **inode, off_t *ofs)
+{
+	struct page_load_info *info = NULL;
+
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+		if (page->uninit.init == lazy_load_segment)
+			info = page->uninit.aux;
+		break;
+	case VM_ANON:
+		info = page->anon.text;
+		/* madvise(DONTNEED)로 내용을 버린 data 페이지는 다시 파일에서 읽음 */
+		if (info == NULL && page->frame == NULL && page->anon.swap_table_idx == SWAP_NONE)
+			info = page->anon.load;
+		break;
+	case VM_FILE:
+		*inode = file_get_inode(page->file.file);
+		*ofs = page->file.offset;
+		return page->file.read_bytes > 0;
+	default:
+		break;
+	}
+	if (info == NULL || info->read_bytes == 0)
+		return false;
+	*inode = file_get_inode(info->file);
+	*ofs = info->offset;
+	return true;
+}
+
+/**
+ * @brief fault-around - 방금 파일에서 올린 PAGE 주변의 페이지를 함께 올리는 함수
+ * 같은 파일에서 va와 같은 간격으로 떨어진 (디스크에서 연속된) 페이지만 올린다.
+ * text cache에 있으면 공유하고, 아니면 eviction 없이 남는 frame이 있을 때만 읽는다.
+ * 파일 락은 한 번만 잡는다.
+ * 쓰기 가능한 data 페이지는 올린 뒤 일반 anon 페이지가 되어 파일 위치를 잃으므로 호출자가 올리기 전에 구해 넘긴다.
+ *
+ * @param page 폴트로 올린 페이지
+ * @param inode 올리기 전 vm_file_pos로 구한 PAGE의 파일
+ * @param ofs 올리기 전 vm_file_pos로 구한 PAGE의 파일 offset
+ */
+static void
+vm_fault_around(struct page *page, struct inode *inode, off_t ofs)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	uint64_t *pml4 = page->owner->pml4;
+	struct inode *near_inode;
+	off_t near_ofs;
+
+	file_fault_cnt++;
+	if (fault_around <= 1)
+		return;
+
+	bool locked = false;
+	if (!lock_held_by_current_thread(&filesys_lock))
+	{
+		lock_acquire(&filesys_lock);
+		locked = true;
+	}
+
+	uint8_t *start = (uint8_t *)page->va - pg_no(page->va) % fault_around * PGSIZE;
+	for (size_t i = 0; i < fault_around; i++)
+	{
+		uint8_t *va = start + i * PGSIZE;
+		struct page *near = spt_find_page(spt, va);
+		if (near == NULL)
+		{
+			/* 아직 만들지 않은 페이지는 파일에서 읽는 부분만 구간에서 만듦 */
+			struct vma *vma = vma_find(spt, va);
+			if (vma == NULL || vma->file == NULL || (size_t)(va - vma->start) >= vma->read_bytes)
+				continue;
+			near = vma_get_page(spt, va);
+		}
+		if (near == NULL || near == page || near->frame != NULL || pml4_get_page(pml4, va) != NULL)
+			continue;
+		if (!vm_file_pos(near, &near_inode, &near_ofs) || near_inode != inode || (ptrdiff_t)(near_ofs - ofs) != va - (uint8_t *)page->va)
+			continue;
+
+		struct page_load_info *text = vm_text_info(near);
+		if (text == NULL || !vm_share_text_page(near, text))
+		{
+			if (!vm_claim_page_nowait(near))
+				break;
+		}
+		fault_around_cnt++;
+	}
+
+	if (locked)
+		lock_release(&filesys_lock);
+}
+
+/**
+ * @brief madvise(DONTNEED) - 페이지의 frame을 내려놓는 함수
+ * file 페이지는 다음 폴트에 파일에서 다시 읽고, anon 페이지는 내용을 버려 다음 폴트에 0으로 채운다.
+ *
+ * @param page
+ * @return true 내려놓은 내용이 있음
+ * @return false 올라와 있지 않거나 eviction 중인 페이지
+ */
+static bool
+vm_discard_page(struct page *page)
+{
+	if (vm_zero_unmap(page))
+		return true;
+	if (page->frame != NULL && page->frame->pin_cnt > 0)
+		return false;
+
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_ANON:
+		return anon_discard(page);
+	case VM_FILE:
+		return file_backed_discard(page);
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief madvise(SEQUENTIAL) - 순차 접근이 지나간 뒤의 페이지들을 정리하는 함수 (drop-behind)
+ * 깨끗한 file 페이지는 바로 내려놓고, 나머지는 accessed 비트를 지워 다른 페이지보다 먼저 내보내지게 한다.
+ * 순차로 읽는 큰 파일이 프로세스의 다른 자주 쓰는 페이지를 밀어내지 않도록 한다.
+ *
+ * @param page 폴트로 올린 페이지
+ */
+static void
+vm_drop_behind(struct page *page)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	uint64_t *pml4 = page->owner->pml4;
+	uint8_t *va = page->va;
+
+	if ((uintptr_t)va < DROP_BEHIND_DIST * PGSIZE)
+		return;
+	va -= DROP_BEHIND_DIST * PGSIZE;
+	for (size_t i = 0; i < DROP_BEHIND_MAX; i++, va -= PGSIZE)
+	{
+		struct page *p = spt_find_page(spt, va);
+		if (p == NULL || p->advice != MADV_SEQUENTIAL || p->frame == NULL)
+			break;
+		if (VM_TYPE(p->operations->type) == VM_FILE && !pml4_is_dirty(pml4, va) && vm_discard_page(p))
+			drop_behind_cnt++;
+		else
+			pml4_set_accessed(pml4, va, false);
+	}
+}
+
+/* PAGE를 올리려면 파일이나 스왑에서 읽어야 하는지 - text cache에 있거나 0으로 채우면 false */
+static bool
+vm_page_needs_read(struct page *page)
+{
+	struct page_load_info *text = vm_text_info(page);
+	struct inode *inode;
+	off_t ofs;
+
+	if (VM_TYPE(page->operations->type) == VM_ANON && page->anon.swap_table_idx != SWAP_NONE && page->anon.swap_table_idx != SWAP_ZERO)
+		return true;
+	if (text != NULL && text_cache_find(file_get_inode(text->file), text->offset) != NULL)
+		return false;
+	return vm_file_pos(page, &inode, &ofs);
+}
+
+/* SPT의 프로세스가 처리한 폴트를 셈 - MAJOR면 파일이나 스왑에서 읽은 폴트 */
+static void
+vm_fault_account(struct supplemental_page_table *spt, bool major)
+{
+	if (major)
+	{
+		spt->major_fault_cnt++;
+		major_fault_cnt++;
+	}
+	else
+	{
+		spt->minor_fault_cnt++;
+		minor_fault_cnt++;
+	}
+}
+
+/* 폴트 처리에 걸린 CYCLES를 히스토그램에 기록 - 구간 b는 [2^b, 2^(b+1)) cycle */
+static void
+vm_fault_record(uint64_t cycles)
+{
+	int b = 0;
+	while (b < FAULT_HIST_CNT - 1 && cycles >> (b + 1) != 0)
+		b++;
+	fault_hist[b]++;
+	fault_cnt++;
+	if (cycles > fault_max)
+		fault_max = cycles;
+}
+
+/* 폴트 처리 시간의 PCT 백분위수 - 해당 구간의 상한 (cycle) */
+static uint64_t
+vm_fault_percentile(int pct)
+{
+	long long sum = 0;
+	for (int b = 0; b < FAULT_HIST_CNT; b++)
+	{
+		sum += fault_hist[b];
+		if (sum * 100 >= fault_cnt * pct)
+			return (uint64_t)1 << (b + 1);
+	}
+	return fault_max;
+}
+
+/**
+ * @brief GITBOOK
+ * TODO: [VM] vm_try_handle_fault 함수 수정
+ *
+ * vm_try_handle_fault 함수를 수정하여 spt_find_page를 통해 페이지 폴트 주소에 해당하는 페이지 구조체를 찾아야 한다.
+ */
+/* Return true on success */
+bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr,
+						 bool user UNUSED, bool write, bool not_present)
+{
+	/* NOTE: [VM] 페이지를 찾아 frame을 올리고 매핑할 때까지 VM 락을 잡음
+	 * 로드가 끝나기 전에 다른 스레드가 frame을 evict하거나 페이지를 해제하지 못한다. */
+	for (;;)
+	{
+		bool locked = vm_lock_acquire();
+		thread_current()->oom_wait = false;
+		bool success = vm_handle_fault(f, addr, user, write, not_present, locked);
+		vm_lock_release(locked);
+		/* NOTE: [VM] 다른 프로세스가 OOM으로 종료하며 frame을 돌려주면 다시 시도
+		 * 호출자가 VM 락을 잡고 있었으면 놓을 수 없으므로 기다리지 않고 실패 */
+		if (success || !locked || !vm_oom_wait())
+			return success;
+	}
+}
+
+/* vm_try_handle_fault - VM 락을 잡은 상태에서 폴트를 처리. LOCKED면 이 폴트가 락을 잡음 */
+static bool
+vm_handle_fault(struct intr_frame *f, void *addr, bool user, bool write, bool not_present, bool locked)
 {
 	struct supplemental_page_table *spt = &thread_current()->spt;
 	struct page *page = NULL;
+	uint64_t start = rdtsc();
+	bool success;
 
 	if (addr == NULL)
 		return false;
@@ -274,8 +1411,28 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr,
 	if (is_kernel_vaddr(addr))
 		return false;
 
+	/* NOTE: [VM] OOM killer가 고른 프로세스는 폴트를 처리하지 않고 종료 */
+	if (thread_current()->oom_killed)
+		return false;
+
 	if (!not_present)
+	{
+		/* NOTE: [VM] COW - 읽기 전용으로 공유 중인 페이지에 쓰기 */
+		page = spt_find_page(spt, addr);
+		if (write && page != NULL && page->writable && page->frame != NULL)
+		{
+			vm_fault_account(spt, false);
+			return vm_handle_wp(page);
+		}
+		/* NOTE: [VM] zero page에 쓰기 - vm_do_claim_page가 매핑을 실제 frame으로 교체 */
+		if (write && page != NULL && page->writable && pml4_get_page(page->owner->pml4, page->va) == zero_page)
+		{
+			zero_fill_cnt++;
+			vm_fault_account(spt, false);
+			return vm_do_claim_page(page);
+		}
 		return false;
+	}
 
 	void *rsp = f->rsp;
 	if (!user)
@@ -287,14 +1444,52 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr,
 	else if (USER_STACK - MAX_STACK_SIZE <= rsp && rsp <= addr && addr <= USER_STACK)
 		vm_stack_growth(addr);
 
-	page = spt_find_page(spt, addr);
+	/* NOTE: [VM] THP - 아직 아무 페이지도 없는 2 MB 블록에 쓰면 블록 전체를 2 MB 페이지 하나로 매핑 */
+	if (write && thp_fault(spt, addr))
+	{
+		vm_fault_account(spt, false);
+		vm_fault_record(rdtsc() - start);
+		return true;
+	}
+
+	/* NOTE: [VM] 구간에 처음 폴트가 난 페이지면 여기서 페이지 구조체를 만듦 */
+	page = vma_get_page(spt, addr);
 	if (page == NULL)
 		return false;
 
 	if (write == 1 && page->writable == 0)
 		return false;
 
-	return vm_do_claim_page(page);
+	/* NOTE: [VM] 내용이 모두 0인 페이지를 읽기만 하면 frame 없이 zero page를 읽기 전용으로 매핑 */
+	bool major = false;
+	if (!write && vm_page_is_zero(page))
+	{
+		zero_map_cnt++;
+		success = pml4_set_page(page->owner->pml4, page->va, zero_page, false);
+	}
+	/* NOTE: [VM] 파일 매핑에서 미리 읽어 둔 페이지면 읽어 둔 frame들을 한꺼번에 매핑 */
+	else if (file_ra_map(page, locked))
+		success = true;
+	else
+	{
+		struct inode *inode;
+		off_t ofs;
+		major = vm_page_needs_read(page);
+		/* 올리고 나면 data 페이지는 파일 위치를 잃으므로 먼저 구함 */
+		bool from_file = vm_file_pos(page, &inode, &ofs);
+		success = vm_do_claim_page(page);
+		/* 순차 접근이면 readahead가 다음 페이지들을 읽으므로 fault-around는 하지 않음
+		 * madvise(RANDOM)이면 둘 다 하지 않음 */
+		if (success && page->advice != MADV_RANDOM && !file_readahead(page) && from_file)
+			vm_fault_around(page, inode, ofs);
+	}
+	if (success && page->advice == MADV_SEQUENTIAL)
+		vm_drop_behind(page);
+
+	/* NOTE: [VM] 페이지를 올린 폴트의 처리 시간을 기록 */
+	vm_fault_account(spt, major);
+	vm_fault_record(rdtsc() - start);
+	return success;
 }
 
 /* Free the page.
@@ -316,11 +1511,113 @@ void vm_dealloc_page(struct page *page)
 bool vm_claim_page(void *va)
 {
 	/* NOTE: va를 위한 페이지를 찾기 - 페이지가 존재하지 않을 때에 대한 처리는 사용하는 곳에서! */
-	struct page *page = spt_find_page(&thread_current()->spt, va);
-	if (page == NULL)
-		return false;
+	bool locked = vm_lock_acquire();
+	struct page *page = vma_get_page(&thread_current()->spt, va);
 	/* NOTE: 해당 페이지를 인자로 갖는 vm_do_claim_page 호출 */
-	return vm_do_claim_page(page);
+	bool success = page != NULL && vm_do_claim_page(page);
+	vm_lock_release(locked);
+	return success;
+}
+
+/* madvise - PAGE 하나에 ADVICE를 적용 */
+static void
+vm_advise_page(struct page *page, int advice)
+{
+	switch (advice)
+	{
+	case MADV_WILLNEED:
+		/* 아직 올라오지 않은 페이지를 미리 올림 */
+		if (page->frame == NULL && pml4_get_page(page->owner->pml4, page->va) == NULL && vm_do_claim_page(page))
+			advise_prefault_cnt++;
+		break;
+	case MADV_DONTNEED:
+		if (vm_discard_page(page))
+			advise_drop_cnt++;
+		break;
+	default:
+		/* NORMAL, RANDOM, SEQUENTIAL은 페이지에 기록해 두고 폴트 때 참고 */
+		page->advice = advice;
+		break;
+	}
+}
+
+/**
+ * @brief madvise - 현재 프로세스의 [ADDR, ADDR + LENGTH) 범위의 페이지에 접근 패턴을 알려 주는 함수
+ * WILLNEED는 페이지를 미리 올리고, DONTNEED는 frame을 내려놓는다. (anon 페이지는 내용을 버림)
+ * SEQUENTIAL은 readahead를 가장 큰 창으로 하고 지나간 페이지를 먼저 내려놓으며, RANDOM은 readahead를 끈다.
+ * 접근 패턴은 구간에 기록해 아직 만들지 않은 페이지도 물려받는다. 매핑되지 않은 주소는 건너뛴다.
+ *
+ * @param addr 페이지 정렬된 시작 주소
+ * @param length 바이트 수
+ * @param advice MADV_*
+ * @return int 성공하면 0, 알 수 없는 advice면 -1
+ */
+int vm_madvise(void *addr, size_t length, int advice)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *start = addr, *end = start + length;
+
+	if (advice < MADV_NORMAL || advice > MADV_DONTNEED)
+		return -1;
+
+	bool locked = vm_lock_acquire();
+	/* WILLNEED는 구간에서 아직 만들지 않은 페이지도 만들어 올림 */
+	if (advice == MADV_WILLNEED)
+		vma_populate(spt, start, end);
+	else if (advice != MADV_DONTNEED)
+		vma_set_advice(spt, start, end, advice);
+
+	/* 범위가 spt보다 크면 범위의 모든 주소 대신 spt의 페이지를 훑음 */
+	if (length / PGSIZE > hash_size(&spt->hash))
+	{
+		struct hash_iterator i;
+		hash_first(&i, &spt->hash);
+		while (hash_next(&i))
+		{
+			struct page *page = hash_entry(hash_cur(&i), struct page, hash_elem);
+			if ((uint8_t *)page->va >= start && (uint8_t *)page->va < end)
+				vm_advise_page(page, advice);
+		}
+	}
+	else
+	{
+		for (uint8_t *va = start; va < end; va += PGSIZE)
+		{
+			struct page *page = spt_find_page(spt, va);
+			if (page != NULL)
+				vm_advise_page(page, advice);
+		}
+	}
+	vm_lock_release(locked);
+	return 0;
+}
+
+/**
+ * @brief 공유 메모리 페이지에 frame을 할당하는 함수
+ * 다른 프로세스가 이미 올려 둔 페이지면 그 frame에 매핑하고, 아니면 새 frame에 세그먼트의 내용을 올린다.
+ * 세그먼트의 페이지는 VM 락이 보호한다.
+ *
+ * @param page
+ * @param shm 페이지가 가리키는 세그먼트의 페이지
+ * @return true
+ * @return false
+ */
+static bool
+vm_claim_shm_page(struct page *page, struct shm_ref *shm)
+{
+	if (shm_resident(shm))
+		return shm_attach(page);
+
+	struct frame *frame = vm_get_frame();
+	if (frame == NULL)
+		return false;
+	/* OOM killer를 기다리며 락을 놓은 사이 다른 프로세스가 올렸으면 얻은 frame은 돌려줌 */
+	if (shm_resident(shm))
+	{
+		vm_release_frame(frame);
+		return shm_attach(page);
+	}
+	return vm_install_frame(page, frame, NULL);
 }
 
 /**
@@ -333,19 +1630,276 @@ bool vm_claim_page(void *va)
 static bool
 vm_do_claim_page(struct page *page)
 {
+	/* NOTE: [VM] text 페이지는 같은 실행 파일을 실행 중인 프로세스와 frame 공유 */
+	struct page_load_info *text = vm_text_info(page);
+	if (text != NULL && vm_share_text_page(page, text))
+		return true;
+
+	/* NOTE: [VM] 공유 메모리 페이지는 세그먼트가 정한 frame을 씀 */
+	struct shm_ref *shm = shm_page_ref(page);
+	if (shm != NULL)
+		return vm_claim_shm_page(page, shm);
+
+	/* NOTE: [VM] zero page를 매핑해 두었던 페이지는 실제 frame으로 교체 */
+	vm_zero_unmap(page);
+
 	struct frame *frame = vm_get_frame(); /* NOTE: [VM] 페이지를 할당할 프레임을 얻음 */
 	if (frame == NULL)
 		return false;
+	return vm_install_frame(page, frame, text);
+}
+
+/**
+ * @brief 남는 frame이 있을 때만 페이지에 frame을 할당하는 함수 - eviction을 일으키지 않음
+ * swap readahead처럼 당장 필요하지 않은 페이지를 미리 올릴 때 사용한다.
+ *
+ * @param page
+ * @return true
+ * @return false 남는 frame이 없거나 로드에 실패
+ */
+bool vm_claim_page_nowait(struct page *page)
+{
+	void *kva = vm_frame_alloc_nowait();
+	if (kva == NULL)
+		return false;
+
+	return vm_install_frame(page, vm_frame_lookup(kva), vm_text_info(page));
+}
+
+/**
+ * @brief 남는 frame이 있을 때만 아직 페이지에 연결하지 않은 frame을 얻는 함수 - eviction을 일으키지 않음
+ * page_list가 빈 frame은 eviction 대상이 아니므로 내용을 채우는 동안 고정하지 않아도 된다.
+ *
+ * @return void* frame의 kva. 남는 frame이 없으면 NULL
+ */
+void *vm_frame_alloc_nowait(void)
+{
+	void *kva = palloc_get_page(PAL_USER);
+	if (kva == NULL)
+		return NULL;
+
+	vm_frame_reset(&frame_table.frames[pg_no(kva) - pg_no(frame_table.base)]);
+	return kva;
+}
+
+/**
+ * @brief 2 MB로 정렬된 연속된 frame HUGE_PGCNT개를 0으로 채워 얻는 함수 - eviction을 일으키지 않음
+ * 각 frame은 vm_frame_alloc_nowait로 얻은 것처럼 페이지에 연결하기 전 상태이며,
+ * 연결하지 않은 frame은 vm_frame_free_unused로 하나씩 돌려준다.
+ *
+ * @return void* 첫 frame의 kva. 비어 있는 2 MB 구간이 없으면 NULL
+ */
+void *vm_frame_alloc_huge(void)
+{
+	uint8_t *kva = palloc_get_huge_page(PAL_USER | PAL_ZERO);
+	if (kva == NULL)
+		return NULL;
+
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+		vm_frame_reset(&frame_table.frames[pg_no(kva + i * PGSIZE) - pg_no(frame_table.base)]);
+	return kva;
+}
+
+/* vm_frame_alloc_nowait로 얻은 뒤 페이지에 연결하지 않은 frame을 돌려줌 */
+void vm_frame_free_unused(void *kva)
+{
+	vm_release_frame(vm_frame_lookup(kva));
+}
+
+/**
+ * @brief vm_frame_alloc_nowait로 얻어 내용을 이미 채운 frame에 PAGE를 연결하고 매핑하는 함수
+ *
+ * @param page 매핑할 페이지 (frame이 없어야 함)
+ * @param kva 페이지의 내용을 담은 frame
+ * @return true
+ * @return false 이미 매핑된 주소 - frame은 호출자가 돌려줘야 함
+ */
+bool vm_frame_adopt(struct page *page, void *kva)
+{
+	uint64_t *pml4 = page->owner->pml4;
+
+	ASSERT(page->frame == NULL);
+	if (pml4_get_page(pml4, page->va) != NULL || !pml4_set_page(pml4, page->va, kva, page->writable))
+		return false;
+	vm_frame_attach(page, kva);
+	return true;
+}
+
+/* 모든 프로세스의 사용량 합계가 바뀐 뒤 최댓값을 갱신 */
+static void
+vm_mem_update_peak(void)
+{
+	size_t used = rss_anon_total + rss_file_total + swap_total;
+	if (used > mem_peak)
+		mem_peak = used;
+}
+
+/**
+ * @brief 페이지의 frame을 FRAME으로 바꾸는 함수 - 소유 프로세스의 상주 페이지 수(rss_anon_cnt, rss_file_cnt)를 함께 맞춤
+ * frame 목록(page_list)은 호출자가 고친다.
+ *
+ * @param page
+ * @param frame 새 frame, frame에서 내려놓으면 NULL
+ */
+void vm_page_set_frame(struct page *page, struct frame *frame)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	bool file = VM_TYPE(page_get_type(page)) == VM_FILE;
+	int delta = (frame != NULL) - (page->frame != NULL);
+
+	page->frame = frame;
+	if (delta == 0)
+		return;
+
+	/* 다른 프로세스의 페이지를 evict할 때도 불리므로 카운터를 고치는 동안 인터럽트를 끔 */
+	enum intr_level old_level = intr_disable();
+	if (file)
+	{
+		spt->rss_file_cnt += delta;
+		rss_file_total += delta;
+	}
+	else
+	{
+		spt->rss_anon_cnt += delta;
+		rss_anon_total += delta;
+	}
+	vm_mem_update_peak();
+	intr_set_level(old_level);
+}
+
+/* SPT의 프로세스가 스왑에 둔 anon 페이지 수를 DELTA만큼 바꿈 */
+void vm_swap_account(struct supplemental_page_table *spt, int delta)
+{
+	enum intr_level old_level = intr_disable();
+	spt->swap_cnt += delta;
+	swap_total += delta;
+	vm_mem_update_peak();
+	intr_set_level(old_level);
+}
+
+/* thread_foreach - 사용자 프로세스 T를 찾음 */
+struct meminfo_find
+{
+	int pid;
+	struct thread *t;
+};
+
+static void
+vm_meminfo_find(struct thread *t, void *find_)
+{
+	struct meminfo_find *find = find_;
+
+	if (t->tid == find->pid && t->pml4 != NULL && t->status != THREAD_DYING)
+		find->t = t;
+}
+
+/**
+ * @brief 프로세스의 메모리 사용량을 INFO에 채우는 함수 - meminfo 시스템 콜
+ *
+ * @param pid MEMINFO_SELF면 현재 프로세스, MEMINFO_ALL이면 모든 프로세스의 합계, 아니면 그 pid의 프로세스
+ * @param info
+ * @return true
+ * @return false PID인 사용자 프로세스가 없음
+ */
+bool vm_meminfo(int pid, struct meminfo *info)
+{
+	struct supplemental_page_table *spt = NULL;
+	bool ok = true;
+	enum intr_level old_level = intr_disable();
+
+	if (pid == MEMINFO_ALL)
+	{
+		info->rss_anon = rss_anon_total;
+		info->rss_file = rss_file_total;
+		info->swap = swap_total;
+		info->committed = commit_total;
+		info->minor_faults = minor_fault_cnt;
+		info->major_faults = major_fault_cnt;
+	}
+	else
+	{
+		struct meminfo_find find = {pid, NULL};
+		if (pid == MEMINFO_SELF)
+			find.t = thread_current();
+		else
+			thread_foreach(vm_meminfo_find, &find);
+		if (find.t != NULL)
+			spt = &find.t->spt;
+		ok = spt != NULL;
+	}
+	if (spt != NULL)
+	{
+		info->rss_anon = spt->rss_anon_cnt;
+		info->rss_file = spt->rss_file_cnt;
+		info->swap = spt->swap_cnt;
+		info->committed = spt->commit_cnt;
+		info->minor_faults = spt->minor_fault_cnt;
+		info->major_faults = spt->major_fault_cnt;
+	}
+	intr_set_level(old_level);
+	return ok;
+}
+
+/**
+ * @brief 내용을 이미 채운 frame에 PAGE를 연결하는 함수 - 매핑은 호출자가 함
+ * 처음 접근하는 페이지면 로드 없이 초기화한다.
+ *
+ * @param page 연결할 페이지 (frame이 없어야 함)
+ * @param kva 페이지의 내용을 담은 frame
+ */
+void vm_frame_attach(struct page *page, void *kva)
+{
+	struct frame *frame = vm_frame_lookup(kva);
+
+	ASSERT(page->frame == NULL);
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		page->uninit.page_initializer(page, page->uninit.type, kva);
+	list_push_back(&frame->page_list, &page->f_elem);
+	vm_page_set_frame(page, frame);
+	vm_queue_insert(frame, page);
+}
+
+/**
+ * @brief 페이지를 FRAME에 연결하고 매핑한 뒤 내용을 채우는 함수
+ *
+ * @param page
+ * @param frame 새로 얻은 frame
+ * @param text 페이지가 text 페이지이면 로드 정보 (text cache에 등록)
+ * @return true
+ * @return false
+ */
+static bool
+vm_install_frame(struct page *page, struct frame *frame, struct page_load_info *text)
+{
+	uint64_t *pml4 = page->owner->pml4;
 
 	/* Set links */
 	// frame->page = page;
 	/* NOTE: frame의 page_list에 page 추가 */
 	list_push_back(&frame->page_list, &page->f_elem);
-	page->frame = frame;
+	vm_page_set_frame(page, frame);
+	vm_queue_insert(frame, page);
 
 	/* NOTE: 페이지 테이블에 페이지의 VA와 프레임의 PA를 삽입 - install_page 참고 */
-	if (pml4_get_page(thread_current()->pml4, page->va) == NULL && pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable))
-		return swap_in(page, frame->kva);
+	if (pml4_get_page(pml4, page->va) == NULL && pml4_set_page(pml4, page->va, frame->kva, page->writable))
+	{
+		/* NOTE: [VM] 내용을 채우는 동안 다른 스레드가 frame을 내보내지 않도록 고정 */
+		frame->pin_cnt++;
+		bool success = swap_in(page, frame->kva);
+		frame->pin_cnt--;
+		if (!success)
+			return false;
+		if (text != NULL)
+		{
+			text_cache_insert(frame, text);
+			text_load_cnt++;
+		}
+		return true;
+	}
+
+	list_remove(&page->f_elem);
+	vm_page_set_frame(page, NULL);
+	vm_free_frame(frame);
 	return false;
 }
 
@@ -390,15 +1944,72 @@ void supplemental_page_table_init(struct supplemental_page_table *spt)
 {
 	/* NOTE: 보조 페이지 테이블 초기화 */
 	hash_init(&spt->hash, page_hash, page_less, NULL);
+	list_init(&spt->ra_list);
+	list_init(&spt->vma_list);
+	spt->vma_cache = NULL;
+	spt->thp_cnt = 0;
+	spt->rss_anon_cnt = 0;
+	spt->rss_file_cnt = 0;
+	spt->swap_cnt = 0;
+	spt->commit_cnt = 0;
+	spt->minor_fault_cnt = 0;
+	spt->major_fault_cnt = 0;
 }
 
 /* Copy supplemental page table from src to dst */
-bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
-								  struct supplemental_page_table *src UNUSED)
+bool supplemental_page_table_copy(struct supplemental_page_table *dst,
+								  struct supplemental_page_table *src)
 {
 	/* TODO: [VM] src부터 dst까지 spt 복사 구현 */
 	/* TODO: spt를 순회하면서 정확한 복사본을 만들어라. */
 	/* TODO: uninit 페이지를 할당하고 이 함수를 바로 요청할 필요가 있을 것이다. */
+	/* NOTE: [VM] 부모의 frame과 page_list를 보는 동안 eviction이 끼어들지 않도록 VM 락을 잡음 */
+	bool locked = vm_lock_acquire();
+	bool success = vm_spt_copy(dst, src);
+	vm_lock_release(locked);
+	return success;
+}
+
+/**
+ * @brief fork - 부모의 실행 파일에서 읽는 로드 정보를 자식의 run_file에서 읽도록 바꾼 복사본을 만드는 함수
+ * 부모는 종료할 때 run_file을 닫으므로 자식이 내보낸 text 페이지를 다시 읽을 때 그 파일을 쓰면 안 된다.
+ *
+ * @param info 부모 페이지의 로드 정보
+ * @return struct page_load_info* 실행 파일이 아니면 INFO 그대로, 메모리가 부족하면 NULL
+ */
+static struct page_load_info *
+vm_load_info_copy(struct page_load_info *info)
+{
+	struct thread *curr = thread_current();
+
+	if (info->file == NULL || info->file != curr->parent->run_file)
+		return info;
+	struct page_load_info *copy = malloc(sizeof *copy);
+	if (copy == NULL)
+		return NULL;
+	*copy = *info;
+	copy->file = curr->run_file;
+	return copy;
+}
+
+/* supplemental_page_table_copy - VM 락을 잡은 상태에서 SRC의 구간과 페이지를 DST에 복사 */
+static bool
+vm_spt_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
+{
+	/* NOTE: [VM] 아직 페이지를 만들지 않은 부분은 구간만 복사하면 자식이 폴트 때 만듦 */
+	if (!vm_commit(dst, src->commit_cnt) || !vma_copy(dst, src))
+		return false;
+	/* 실행 파일의 segment 구간은 자식의 run_file에서 읽음 */
+	for (struct list_elem *e = list_begin(&dst->vma_list); e != list_end(&dst->vma_list); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->file != NULL && vma->file == thread_current()->parent->run_file)
+			vma->file = thread_current()->run_file;
+	}
+	/* NOTE: [VM] THP - 페이지마다 따로 읽기 전용으로 바꿀 수 있도록 부모의 2 MB 매핑을 먼저 나눔 */
+	if (!thp_split_all(src))
+		return false;
+
 	struct hash_iterator i;
 	hash_first(&i, &src->hash);
 	while (hash_next(&i))
@@ -407,42 +2018,60 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 		enum vm_type type = src_page->operations->type;
 		void *upage = src_page->va;
 		bool writable = src_page->writable;
+		/* NOTE: [VM] 공유 메모리 페이지는 복사하지 않음 - 자식은 물려받은 구간에서 폴트 때 같은 frame에 매핑 */
+		if (shm_page_ref(src_page) != NULL)
+			continue;
 		if (type == VM_UNINIT)
 		{
 			vm_initializer *init = src_page->uninit.init;
 			void *aux = src_page->uninit.aux;
-			vm_alloc_page_with_initializer(page_get_type(src_page), upage, writable, init, aux);
+			if (init == lazy_load_segment && (aux = vm_load_info_copy(aux)) == NULL)
+				return false;
+			if (vm_alloc_page_with_initializer(page_get_type(src_page), upage, writable, init, aux))
+				spt_find_page(dst, upage)->advice = src_page->advice;
 			continue;
 		}
 
-		if (type == VM_FILE)
+		/* NOTE: [VM] COW - 페이지 구조체만 복사하고 frame은 부모와 공유 */
+		struct page *dst_page = malloc(sizeof(struct page));
+		if (dst_page == NULL)
+			return false;
+		*dst_page = *src_page;
+		dst_page->owner = thread_current();
+		dst_page->frame = NULL;
+		if (type == VM_ANON && ((dst_page->anon.text != NULL && (dst_page->anon.text = vm_load_info_copy(dst_page->anon.text)) == NULL) ||
+								(dst_page->anon.load != NULL && (dst_page->anon.load = vm_load_info_copy(dst_page->anon.load)) == NULL)))
 		{
-			struct page_load_info *file_aux = malloc(sizeof(struct page_load_info));
-			file_aux->file = src_page->file.file;
-			file_aux->offset = src_page->file.offset;
-			file_aux->read_bytes = src_page->file.read_bytes;
-			// file_aux->zero_bytes = src_page->file.zero_bytes;
-
-			if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, file_aux))
-				return false;
-			struct page *file_page = spt_find_page(dst, upage);
-			file_backed_initializer(file_page, type, NULL);
-			file_page->frame = src_page->frame;
-			pml4_set_page(thread_current()->pml4, file_page->va, src_page->frame->kva, src_page->writable);
-			continue;
+			free(dst_page);
+			return false;
 		}
-
-		if (!vm_alloc_page(type, upage, writable))
+		if (!spt_insert_page(dst, dst_page))
+		{
+			free(dst_page);
 			return false;
+		}
 
-		if (!vm_claim_page(upage))
-			return false;
+		struct frame *frame = src_page->frame;
+		if (frame == NULL)
+		{
+			/* 스왑된 anon 페이지는 스왑 슬롯을 공유 */
+			if (type == VM_ANON && src_page->anon.swap_table_idx != SWAP_NONE)
+			{
+				anon_swap_slot_dup(src_page->anon.swap_table_idx);
+				if (src_page->anon.swap_table_idx != SWAP_ZERO)
+					vm_swap_account(dst, 1);
+			}
+			continue;
+		}
 
-		struct page *dst_page = spt_find_page(dst, upage);
-		if (dst_page == NULL)
+		/* 부모와 자식 모두 읽기 전용으로 매핑 - 쓰기 시 vm_handle_wp에서 복사 */
+		if (writable)
+			pml4_set_writable(src_page->owner->pml4, upage, false);
+		if (!pml4_set_page(thread_current()->pml4, upage, frame->kva, false))
 			return false;
-
-		memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+		list_push_back(&frame->page_list, &dst_page->f_elem);
+		vm_page_set_frame(dst_page, frame);
+		cow_share_cnt++;
 	}
 	return true;
 }
@@ -450,6 +2079,8 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 void hash_action_destroy(struct hash_elem *e, void *aux)
 {
 	struct page *page = hash_entry(e, struct page, hash_elem);
+	/* NOTE: [VM] zero page는 pml4_destroy가 해제하지 않도록 매핑을 먼저 제거 */
+	vm_zero_unmap(page);
 	vm_dealloc_page(page);
 }
 
@@ -465,5 +2096,55 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt)
 	 * 페이지 엔트리를 순회하면서 테이블의 페이지에 destroy(page)를 호출해야 한다.
 	 * 실제 페이지 테이블(pml4)와 물리 주소(palloc된 메모리)에 대해선 고려하지 않아도 된다. (호출자가 그것들을 정리할 것이다.)
 	 */
+	/* NOTE: [VM] 진행 중인 readahead를 기다린 뒤 읽어 둔 frame을 돌려줌 */
+	file_ra_kill(spt);
+	/* NOTE: [VM] kswapd가 이 프로세스의 페이지를 내보내는 중이면 끝날 때까지 기다린 뒤 해제 */
+	bool locked = vm_lock_acquire();
+	/* NOTE: [VM] 2 MB 매핑은 페이지마다 나누지 않고 한 번에 지움 - frame은 각 페이지의 destroy가 해제 */
+	thp_kill(spt);
+	vma_kill(spt);
 	hash_clear(&spt->hash, hash_action_destroy); /* 🚨 왜 hash_destroy를 사용하면 PANIC이 뜰까?! */
+	vm_lock_release(locked);
+	vm_uncommit(spt, spt->commit_cnt);
+}
+
+/* Prints VM statistics. */
+void vm_print_stats(void)
+{
+	printf("COW: %lld pages shared, %lld copied, %lld reused\n",
+		   cow_share_cnt, cow_copy_cnt, cow_reuse_cnt);
+	printf("Text: %lld pages loaded, %lld shared\n",
+		   text_load_cnt, text_hit_cnt);
+	printf("Zero: %lld read faults mapped the zero page, %lld filled on write\n",
+		   zero_map_cnt, zero_fill_cnt);
+	printf("Frames: %zu of %zu in use, peak %zu; %zu free pages pre-zeroed\n",
+		   frame_used_cnt, frame_table.frame_cnt, frame_peak_cnt, palloc_zero_cnt(PAL_USER));
+	ksm_print_stats();
+	thp_print_stats();
+	printf("Fault latency: %lld faults, p50 < %llu, p90 < %llu, p99 < %llu, max %llu cycles\n",
+		   fault_cnt, vm_fault_percentile(50), vm_fault_percentile(90),
+		   vm_fault_percentile(99), fault_max);
+	printf("Fault-around: %lld pages mapped around %lld file faults; "
+		   "%lld faults in %lld execs (%lld per exec)\n",
+		   fault_around_cnt, file_fault_cnt, fault_cnt, exec_cnt,
+		   exec_cnt > 0 ? fault_cnt / exec_cnt : 0);
+	printf("Advice: %lld pages prefaulted, %lld dropped, %lld dropped behind\n",
+		   advise_prefault_cnt, advise_drop_cnt, drop_behind_cnt);
+	if (kswapd_enabled)
+		printf("Reclaim: %lld direct, %lld by kswapd in %lld wakeups (watermarks %zu/%zu free frames)\n",
+			   direct_reclaim_cnt, kswapd_reclaim_cnt, kswapd_wake_cnt, kswapd_low, kswapd_high);
+	else
+		printf("Reclaim: %lld direct\n", direct_reclaim_cnt);
+	printf("OOM: %lld processes killed; %zu pages committed, peak %zu, limit %zu (%s), %lld refused\n",
+		   oom_kill_cnt, commit_total, commit_peak, vm_commit_limit(),
+		   vm_overcommit == VM_OVERCOMMIT_NEVER ? "never" : vm_overcommit == VM_OVERCOMMIT_HEURISTIC ? "heuristic" : "always",
+		   commit_fail_cnt);
+	printf("Memory: %lld minor faults, %lld major; %zu anon + %zu file pages resident, %zu swapped, peak %zu\n",
+		   minor_fault_cnt, major_fault_cnt, rss_anon_total, rss_file_total, swap_total, mem_peak);
+	file_print_stats();
+	anon_print_stats();
+	shm_print_stats();
+	printf("Replacement: %s, %lld evictions (%lld cold), %lld promoted\n",
+		   vm_policy == VM_POLICY_2Q ? "2q" : "clock",
+		   evict_cnt, evict_cold_cnt, promote_cnt);
 }
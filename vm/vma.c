@@ -0,0 +1,388 @@
+/* vma.c: Memory regions - describes the mappings of a process so that pages are created on first fault. */
+
+#include "vm/vma.h"
+#include "vm/vm.h"
+#include "vm/shm.h"
+#include <round.h>
+#include <syscall-nr.h>
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+
+/* NOTE: [VM] 구간 밖의 페이지를 한 번에 지울 때 spt에서 모아 두는 페이지 수 */
+#define VMA_REMOVE_BATCH 64
+
+/* 구간이 예약(vm_commit)하는 페이지 수 - 쓰기 가능한 anon 구간만 예약한다.
+ * 공유 메모리는 매핑한 프로세스마다 세지 않도록 예약하지 않는다. */
+static size_t
+vma_charge(const struct vma *vma)
+{
+	return VM_TYPE(vma->type) == VM_ANON && vma->writable && vma->shm == NULL ? (size_t)(vma->end - vma->start) / PGSIZE : 0;
+}
+
+/* VMA를 SPT의 구간 목록에 넣음 - 겹치면 실패 */
+static bool
+vma_insert(struct supplemental_page_table *spt, struct vma *vma)
+{
+	if (vma_overlaps(spt, vma->start, vma->end))
+		return false;
+
+	/* NOTE: [VM] overcommit 정책이 거절하면 구간을 만들지 않음 */
+	if (!vm_commit(spt, vma_charge(vma)))
+		return false;
+
+	/* start 순서 유지 */
+	struct list_elem *e;
+	for (e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e))
+		if (list_entry(e, struct vma, elem)->start > vma->start)
+			break;
+	list_insert(e, &vma->elem);
+	return true;
+}
+
+/**
+ * @brief [START, START + LENGTH) 구간을 SPT에 등록하는 함수
+ * 페이지 구조체는 만들지 않는다. 이미 등록된 구간과 겹치면 실패한다.
+ *
+ * @param spt
+ * @param start 페이지 정렬된 시작 주소
+ * @param length 바이트 수 - 페이지 단위로 올림
+ * @param type 구간에 만들 페이지의 타입
+ * @param writable
+ * @param file 내용을 읽을 파일
+ * @param offset START에 해당하는 파일 offset
+ * @param read_bytes 파일에서 읽을 바이트 수 (나머지는 0)
+ * @return true
+ * @return false 구간이 겹치거나 메모리가 부족함
+ */
+bool vma_map(struct supplemental_page_table *spt, void *start, size_t length, enum vm_type type,
+			 bool writable, struct file *file, off_t offset, size_t read_bytes)
+{
+	ASSERT(pg_ofs(start) == 0);
+
+	uint8_t *end = (uint8_t *)start + ROUND_UP(length, PGSIZE);
+	if (length == 0 || end < (uint8_t *)start)
+		return false;
+
+	struct vma *vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return false;
+	vma->start = start;
+	vma->end = end;
+	vma->type = type;
+	vma->writable = writable;
+	vma->file = file;
+	vma->offset = offset;
+	vma->read_bytes = read_bytes;
+	vma->advice = MADV_NORMAL;
+	vma->shm = NULL;
+
+	if (!vma_insert(spt, vma))
+	{
+		free(vma);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief 공유 메모리 세그먼트 SEG의 앞부분을 [START, START + LENGTH) 구간으로 등록하는 함수
+ * 호출자가 넘겨준 세그먼트의 참조(shm_vma_get)는 구간이 가진다. 실패하면 호출자가 놓는다.
+ *
+ * @return false 구간이 겹치거나 메모리가 부족함
+ */
+bool vma_map_shm(struct supplemental_page_table *spt, void *start, size_t length, struct shm_segment *seg)
+{
+	ASSERT(pg_ofs(start) == 0 && pg_ofs(length) == 0);
+
+	uint8_t *end = (uint8_t *)start + length;
+	if (length == 0 || end < (uint8_t *)start)
+		return false;
+
+	struct vma *vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return false;
+	vma->start = start;
+	vma->end = end;
+	vma->type = VM_ANON | VM_SHM;
+	vma->writable = true;
+	vma->file = NULL;
+	vma->offset = 0;
+	/* 파일은 없지만 나눈 구간의 offset이 세그먼트의 위치를 따라가도록 전체를 읽는 구간으로 둠 */
+	vma->read_bytes = length;
+	vma->advice = MADV_NORMAL;
+	vma->shm = seg;
+
+	if (!vma_insert(spt, vma))
+	{
+		free(vma);
+		return false;
+	}
+	return true;
+}
+
+/* SPT에서 VA를 포함하는 구간을 찾음 - 없으면 NULL. 마지막으로 찾은 구간을 먼저 본다. */
+struct vma *
+vma_find(struct supplemental_page_table *spt, void *va)
+{
+	uint8_t *p = va;
+	struct vma *vma = spt->vma_cache;
+
+	if (vma != NULL && vma->start <= p && p < vma->end)
+		return vma;
+	for (struct list_elem *e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e))
+	{
+		vma = list_entry(e, struct vma, elem);
+		if (p < vma->start)
+			break;
+		if (p < vma->end)
+		{
+			spt->vma_cache = vma;
+			return vma;
+		}
+	}
+	return NULL;
+}
+
+/* [START, END)와 겹치는 구간이 있는지 */
+bool vma_overlaps(struct supplemental_page_table *spt, void *start, void *end)
+{
+	for (struct list_elem *e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->start >= (uint8_t *)end)
+			break;
+		if (vma->end > (uint8_t *)start)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @brief VA의 페이지를 찾고, 아직 없으면 VA를 포함하는 구간에서 만드는 함수
+ * 현재 프로세스의 spt에만 사용할 수 있다. (vm_alloc_page_with_initializer가 현재 프로세스에 만듦)
+ *
+ * @param spt 현재 프로세스의 spt
+ * @param va
+ * @return struct page* 페이지도 구간도 없으면 NULL
+ */
+struct page *
+vma_get_page(struct supplemental_page_table *spt, void *va)
+{
+	struct page *page = spt_find_page(spt, va);
+	if (page != NULL)
+		return page;
+
+	struct vma *vma = vma_find(spt, va);
+	if (vma == NULL)
+		return NULL;
+	ASSERT(spt == &thread_current()->spt);
+
+	uint8_t *upage = pg_round_down(va);
+	size_t skip = upage - vma->start;
+
+	/* NOTE: [VM] 공유 메모리 구간은 세그먼트의 페이지를 가리키는 페이지를 만듦 */
+	if (vma->shm != NULL)
+	{
+		if (!shm_alloc_page(vma->shm, (vma->offset + skip) / PGSIZE, upage, vma->writable))
+			return NULL;
+		page = spt_find_page(spt, upage);
+		page->advice = vma->advice;
+		return page;
+	}
+
+	struct page_load_info *info = malloc(sizeof *info);
+	if (info == NULL)
+		return NULL;
+	info->file = vma->file;
+	info->offset = vma->offset + (vma->read_bytes < skip ? vma->read_bytes : skip);
+	info->read_bytes = vma->read_bytes <= skip ? 0 : vma->read_bytes - skip < PGSIZE ? vma->read_bytes - skip
+																					   : PGSIZE;
+	info->zero_bytes = PGSIZE - info->read_bytes;
+
+	if (!vm_alloc_page_with_initializer(vma->type, upage, vma->writable, lazy_load_segment, info))
+	{
+		free(info);
+		return NULL;
+	}
+	page = spt_find_page(spt, upage);
+	page->advice = vma->advice;
+	return page;
+}
+
+/* [START, END) 범위에서 구간에 속한 페이지 구조체를 모두 만듦 - madvise(WILLNEED) */
+void vma_populate(struct supplemental_page_table *spt, void *start, void *end)
+{
+	for (struct list_elem *e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->start >= (uint8_t *)end)
+			break;
+
+		uint8_t *va = vma->start > (uint8_t *)start ? vma->start : (uint8_t *)start;
+		uint8_t *last = vma->end < (uint8_t *)end ? vma->end : (uint8_t *)end;
+		for (; va < last; va += PGSIZE)
+			if (vma_get_page(spt, va) == NULL)
+				return;
+	}
+}
+
+/**
+ * @brief 구간 VMA를 AT에서 둘로 나누는 함수 - 뒤쪽이 새 구간이 된다.
+ *
+ * @return struct vma* 뒤쪽 구간, 메모리가 부족하면 NULL
+ */
+static struct vma *
+vma_split(struct vma *vma, uint8_t *at)
+{
+	ASSERT(vma->start < at && at < vma->end);
+
+	struct vma *tail = malloc(sizeof *tail);
+	if (tail == NULL)
+		return NULL;
+	size_t skip = at - vma->start;
+
+	*tail = *vma;
+	tail->start = at;
+	tail->offset = vma->offset + (vma->read_bytes < skip ? vma->read_bytes : skip);
+	tail->read_bytes = vma->read_bytes <= skip ? 0 : vma->read_bytes - skip;
+	vma->end = at;
+	vma->read_bytes -= tail->read_bytes;
+	list_insert(list_next(&vma->elem), &tail->elem);
+	if (tail->shm != NULL)
+		shm_vma_get(tail->shm);
+	return tail;
+}
+
+/**
+ * @brief [START, END) 범위의 구간에 접근 패턴을 기록하는 함수
+ * 이후 만들어지는 페이지가 ADVICE를 물려받는다. 범위 경계에 걸친 구간은 나눈다.
+ * 이미 있는 페이지는 호출하는 쪽에서 처리한다.
+ */
+void vma_set_advice(struct supplemental_page_table *spt, void *start, void *end, int advice)
+{
+	struct list_elem *e = list_begin(&spt->vma_list);
+	while (e != list_end(&spt->vma_list))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->start >= (uint8_t *)end)
+			break;
+		e = list_next(e);
+		if (vma->end <= (uint8_t *)start || vma->advice == advice)
+			continue;
+
+		/* 범위 밖 부분은 원래 advice로 남김 */
+		if (vma->start < (uint8_t *)start)
+		{
+			vma = vma_split(vma, start);
+			if (vma == NULL)
+				return;
+		}
+		if ((uint8_t *)end < vma->end && vma_split(vma, end) == NULL)
+			return;
+		vma->advice = advice;
+		e = list_next(&vma->elem);
+	}
+}
+
+/* [START, END) 범위의 페이지를 spt에서 모두 제거 */
+static void
+vma_remove_pages(struct supplemental_page_table *spt, uint8_t *start, uint8_t *end)
+{
+	/* 만든 페이지가 범위보다 적으면 범위의 모든 주소 대신 spt의 페이지를 훑음
+	 * 훑는 동안에는 hash에서 지울 수 없으므로 조금씩 모아서 지운다. */
+	if ((size_t)(end - start) / PGSIZE > hash_size(&spt->hash))
+	{
+		struct page *batch[VMA_REMOVE_BATCH];
+		size_t cnt;
+		do
+		{
+			struct hash_iterator i;
+			cnt = 0;
+			hash_first(&i, &spt->hash);
+			while (cnt < VMA_REMOVE_BATCH && hash_next(&i))
+			{
+				struct page *page = hash_entry(hash_cur(&i), struct page, hash_elem);
+				if ((uint8_t *)page->va >= start && (uint8_t *)page->va < end)
+					batch[cnt++] = page;
+			}
+			for (size_t k = 0; k < cnt; k++)
+				spt_remove_page(spt, batch[k]);
+		} while (cnt == VMA_REMOVE_BATCH);
+		return;
+	}
+
+	for (uint8_t *va = start; va < end; va += PGSIZE)
+	{
+		struct page *page = spt_find_page(spt, va);
+		if (page != NULL)
+			spt_remove_page(spt, page);
+	}
+}
+
+/**
+ * @brief START에서 시작하는 매핑을 통째로 해제하는 함수 - munmap
+ * madvise로 나뉜 구간들(같은 파일이나 세그먼트로 이어지는 구간)도 함께 해제하고, 만들어 둔 페이지를 모두 제거한다.
+ *
+ * @param spt
+ * @param start 매핑의 시작 주소
+ */
+void vma_unmap(struct supplemental_page_table *spt, void *start)
+{
+	struct vma *first = vma_find(spt, start);
+	if (first == NULL || first->start != (uint8_t *)start)
+		return;
+
+	struct file *file = first->file;
+	struct shm_segment *shm = first->shm;
+	uint8_t *end = first->start;
+	off_t offset = first->offset;
+	struct list_elem *e = &first->elem;
+	while (e != list_end(&spt->vma_list))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		/* 나뉜 구간은 offset이 이어짐 - 같은 파일이나 세그먼트를 바로 뒤에 다시 매핑한 구간은 따로 해제 */
+		if (vma->start != end || vma->file != file || vma->shm != shm || vma->offset != offset)
+			break;
+		size_t size = vma->end - vma->start;
+		offset = vma->offset + (vma->read_bytes < size ? vma->read_bytes : size);
+		end = vma->end;
+		e = list_remove(e);
+		vm_uncommit(spt, vma_charge(vma));
+		if (vma->shm != NULL)
+			shm_vma_put(vma->shm);
+		free(vma);
+	}
+	spt->vma_cache = NULL;
+	vma_remove_pages(spt, start, end);
+}
+
+/* fork - SRC의 구간들을 DST에 복사 */
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
+{
+	for (struct list_elem *e = list_begin(&src->vma_list); e != list_end(&src->vma_list); e = list_next(e))
+	{
+		struct vma *vma = malloc(sizeof *vma);
+		if (vma == NULL)
+			return false;
+		*vma = *list_entry(e, struct vma, elem);
+		list_push_back(&dst->vma_list, &vma->elem);
+		if (vma->shm != NULL)
+			shm_vma_get(vma->shm);
+	}
+	return true;
+}
+
+/* SPT의 구간을 모두 해제 - 페이지는 supplemental_page_table_kill이 제거 */
+void vma_kill(struct supplemental_page_table *spt)
+{
+	while (!list_empty(&spt->vma_list))
+	{
+		struct vma *vma = list_entry(list_pop_front(&spt->vma_list), struct vma, elem);
+		if (vma->shm != NULL)
+			shm_vma_put(vma->shm);
+		free(vma);
+	}
+	spt->vma_cache = NULL;
+}
@@ -0,0 +1,490 @@
+/* zswap.c: Compressed cache of swapped-out anonymous pages in front of the swap disk. */
+
+#include <stdio.h>
+#include <string.h>
+#include <round.h>
+#include "vm/zswap.h"
+#include "lib/kernel/hash.h"
+#include "lib/kernel/list.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* NOTE: [VM] 압축 결과가 이보다 크면 압축하지 않고 바로 디스크에 씀 */
+#define ZSWAP_MAX_LEN (PGSIZE * 3 / 4)
+
+/* NOTE: [VM] pool 페이지는 64바이트 chunk 단위로 나누어 최대 두 개의 압축 페이지를 담음 (zbud)
+ * 하나는 페이지 앞에서부터, 다른 하나는 페이지 끝에 붙여서 놓는다. */
+#define CHUNK_SIZE 64
+#define NCHUNKS (PGSIZE / CHUNK_SIZE)
+
+/* pool 페이지 하나 */
+struct zpage
+{
+	void *kva;					/* 압축된 데이터를 담는 커널 페이지 */
+	struct zswap_entry *first;	/* 페이지 앞에 놓인 항목 */
+	struct zswap_entry *last;	/* 페이지 끝에 놓인 항목 */
+	struct list_elem elem;		/* 항목이 하나뿐일 때 unbuddied에 넣을 elem */
+};
+
+/* 압축해서 저장한 스왑 슬롯 하나 */
+struct zswap_entry
+{
+	size_t slot;			   /* 스왑 슬롯 번호 */
+	struct zpage *zpage;	   /* 데이터가 있는 pool 페이지 */
+	bool last;				   /* pool 페이지의 끝에 놓였는지 */
+	size_t len;				   /* 압축된 길이 */
+	struct hash_elem elem;	   /* entries에 넣을 elem */
+	struct list_elem lru_elem; /* lru에 넣을 elem */
+};
+
+static struct lock zswap_lock;
+static struct hash entries;				/* 슬롯 번호 -> 항목 */
+static struct list lru;					/* 오래 저장된 항목부터 */
+static struct list unbuddied[NCHUNKS];	/* 항목이 하나뿐인 pool 페이지 - 남은 chunk 수별 */
+static size_t pool_pages, max_pool_pages;
+static zswap_writeback_func *writeback;
+static bool zswap_enabled;
+
+/* 압축 / 내보내기에 쓰는 버퍼 - zswap_lock으로 보호 */
+static uint8_t zbuf[PGSIZE];
+static uint8_t wbbuf[PGSIZE];
+
+static long long stored_cnt;	/* 압축해서 저장한 페이지 수 */
+static long long rejected_cnt;	/* 압축이 잘 안 돼 디스크로 보낸 페이지 수 */
+static long long hit_cnt;		/* 캐시에서 읽은 페이지 수 */
+static long long miss_cnt;		/* 디스크에서 읽어야 했던 페이지 수 */
+static long long writeback_cnt; /* pool이 가득 차 디스크로 내보낸 페이지 수 */
+static long long bytes_in;		/* 저장한 페이지의 원래 크기 합 */
+static long long bytes_out;		/* 저장한 페이지의 압축된 크기 합 */
+
+static uint64_t entry_hash(const struct hash_elem *e, void *aux);
+static bool entry_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+
+/**
+ * @brief 압축 스왑 캐시를 초기화하는 함수
+ *
+ * @param max_pages pool로 쓸 수 있는 최대 커널 페이지 수 (0이면 캐시를 쓰지 않음)
+ * @param wb pool이 가득 찼을 때 오래된 페이지를 스왑 디스크에 쓰는 함수
+ */
+void zswap_init(size_t max_pages, zswap_writeback_func *wb)
+{
+	lock_init(&zswap_lock);
+	hash_init(&entries, entry_hash, entry_less, NULL);
+	list_init(&lru);
+	for (size_t i = 0; i < NCHUNKS; i++)
+		list_init(&unbuddied[i]);
+	max_pool_pages = max_pages;
+	writeback = wb;
+	zswap_enabled = max_pages > 0;
+}
+
+static uint64_t
+entry_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	return hash_bytes(&hash_entry(e, struct zswap_entry, elem)->slot, sizeof(size_t));
+}
+
+static bool
+entry_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	return hash_entry(a, struct zswap_entry, elem)->slot < hash_entry(b, struct zswap_entry, elem)->slot;
+}
+
+/* 슬롯 SLOT의 항목을 찾음 */
+static struct zswap_entry *
+entry_find(size_t slot)
+{
+	struct zswap_entry key;
+	struct hash_elem *e;
+
+	key.slot = slot;
+	e = hash_find(&entries, &key.elem);
+	return e != NULL ? hash_entry(e, struct zswap_entry, elem) : NULL;
+}
+
+/* 항목 E가 차지하는 chunk 수 */
+static size_t
+entry_chunks(const struct zswap_entry *e)
+{
+	return e != NULL ? DIV_ROUND_UP(e->len, CHUNK_SIZE) : 0;
+}
+
+/* pool 페이지 ZP에 남은 chunk 수 */
+static size_t
+zpage_free_chunks(const struct zpage *zp)
+{
+	return NCHUNKS - entry_chunks(zp->first) - entry_chunks(zp->last);
+}
+
+/* pool 페이지 ZP 안에서 항목 E의 데이터 위치 */
+static uint8_t *
+entry_data(const struct zswap_entry *e)
+{
+	uint8_t *kva = e->zpage->kva;
+	return e->last ? kva + PGSIZE - entry_chunks(e) * CHUNK_SIZE : kva;
+}
+
+/* 항목 E를 캐시에서 지움 - pool 페이지가 비면 해제 */
+static void
+entry_remove(struct zswap_entry *e)
+{
+	struct zpage *zp = e->zpage;
+
+	/* 두 항목이 모두 있던 페이지는 unbuddied에 없음 */
+	if (zp->first == NULL || zp->last == NULL)
+		list_remove(&zp->elem);
+	if (e->last)
+		zp->last = NULL;
+	else
+		zp->first = NULL;
+
+	if (zp->first == NULL && zp->last == NULL)
+	{
+		palloc_free_page(zp->kva);
+		free(zp);
+		pool_pages--;
+	}
+	else
+		list_push_back(&unbuddied[zpage_free_chunks(zp)], &zp->elem);
+
+	hash_delete(&entries, &e->elem);
+	list_remove(&e->lru_elem);
+	free(e);
+}
+
+/* 가장 오래된 항목을 압축을 풀어 스왑 디스크에 쓰고 캐시에서 지움 */
+static void
+zswap_writeback_oldest(void)
+{
+	struct zswap_entry *e = list_entry(list_front(&lru), struct zswap_entry, lru_elem);
+	size_t len = lz_decompress(entry_data(e), e->len, wbbuf, PGSIZE);
+
+	ASSERT(len == PGSIZE);
+	writeback(e->slot, wbbuf);
+	entry_remove(e);
+	writeback_cnt++;
+}
+
+/**
+ * @brief CHUNKS개의 chunk를 담을 수 있는 pool 페이지를 찾는 함수
+ * 항목이 하나뿐인 페이지 중 남는 공간이 가장 작은 것을 쓰고, 없으면 새 페이지를 할당한다.
+ * pool이 가득 찼으면 오래된 항목부터 디스크로 내보내 자리를 만든다.
+ *
+ * @return struct zpage* 찾은 페이지, 자리를 만들 수 없으면 NULL
+ */
+static struct zpage *
+zpage_find(size_t chunks)
+{
+	for (;;)
+	{
+		for (size_t i = chunks; i < NCHUNKS; i++)
+			if (!list_empty(&unbuddied[i]))
+				return list_entry(list_pop_front(&unbuddied[i]), struct zpage, elem);
+
+		if (pool_pages < max_pool_pages)
+		{
+			struct zpage *zp = malloc(sizeof *zp);
+			void *kva = zp != NULL ? palloc_get_page(0) : NULL;
+			if (kva != NULL)
+			{
+				zp->kva = kva;
+				zp->first = zp->last = NULL;
+				pool_pages++;
+				return zp;
+			}
+			free(zp);
+			/* 커널 pool이 부족하면 지금 크기를 최대로 삼음 */
+			max_pool_pages = pool_pages;
+		}
+
+		if (list_empty(&lru))
+			return NULL;
+		zswap_writeback_oldest();
+	}
+}
+
+/**
+ * @brief 스왑 슬롯 SLOT에 쓸 PAGE를 압축해 캐시에 저장하는 함수
+ *
+ * @return true 저장함 - 디스크에 쓰지 않아도 됨
+ * @return false 압축이 잘 안 되거나 자리가 없음 - 호출한 쪽이 디스크에 써야 함
+ */
+bool zswap_store(size_t slot, const void *page)
+{
+	struct zswap_entry *e, *old;
+	struct zpage *zp;
+	size_t len;
+
+	if (!zswap_enabled)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	old = entry_find(slot);
+	if (old != NULL)
+		entry_remove(old);
+
+	len = lz_compress(page, PGSIZE, zbuf, ZSWAP_MAX_LEN);
+	e = len != 0 ? malloc(sizeof *e) : NULL;
+	zp = e != NULL ? zpage_find(DIV_ROUND_UP(len, CHUNK_SIZE)) : NULL;
+	if (zp == NULL)
+	{
+		free(e);
+		rejected_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+
+	/* 빈 쪽에 놓음 - 두 자리가 모두 차면 unbuddied에서 빠진 채로 둠 */
+	e->slot = slot;
+	e->zpage = zp;
+	e->len = len;
+	e->last = zp->first != NULL;
+	if (e->last)
+		zp->last = e;
+	else
+		zp->first = e;
+	if (zp->first == NULL || zp->last == NULL)
+		list_push_back(&unbuddied[zpage_free_chunks(zp)], &zp->elem);
+	memcpy(entry_data(e), zbuf, len);
+
+	hash_insert(&entries, &e->elem);
+	list_push_back(&lru, &e->lru_elem);
+	stored_cnt++;
+	bytes_in += PGSIZE;
+	bytes_out += len;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/**
+ * @brief 스왑 슬롯 SLOT이 캐시에 있으면 압축을 풀어 PAGE에 읽는 함수
+ * 슬롯을 공유하는 페이지가 남아 있을 수 있으므로 항목은 슬롯이 해제될 때 지운다.
+ *
+ * @return true 캐시에서 읽음
+ * @return false 캐시에 없음 - 호출한 쪽이 디스크에서 읽어야 함
+ */
+bool zswap_load(size_t slot, void *page)
+{
+	struct zswap_entry *e;
+
+	if (!zswap_enabled)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	e = entry_find(slot);
+	if (e == NULL)
+	{
+		miss_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	if (lz_decompress(entry_data(e), e->len, page, PGSIZE) != PGSIZE)
+		PANIC("zswap: slot %zu is corrupted", slot);
+	hit_cnt++;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* 스왑 슬롯 SLOT이 해제될 때 캐시에서도 지움 */
+void zswap_invalidate(size_t slot)
+{
+	struct zswap_entry *e;
+
+	if (!zswap_enabled)
+		return;
+
+	lock_acquire(&zswap_lock);
+	e = entry_find(slot);
+	if (e != NULL)
+		entry_remove(e);
+	lock_release(&zswap_lock);
+}
+
+/* Prints compressed swap cache statistics. */
+void zswap_print_stats(void)
+{
+	long long lookups = hit_cnt + miss_cnt;
+	long long ratio = bytes_out > 0 ? bytes_in * 100 / bytes_out : 0;
+
+	printf("Zswap: %lld stored, %lld rejected, %lld written back, "
+		   "%lld hits, %lld misses (%lld%% hit rate)\n",
+		   stored_cnt, rejected_cnt, writeback_cnt, hit_cnt, miss_cnt,
+		   lookups > 0 ? hit_cnt * 100 / lookups : 0);
+	printf("Zswap pool: %lld bytes compressed to %lld (ratio %lld.%02lld), "
+		   "%zu stored in %zu of %zu pages\n",
+		   bytes_in, bytes_out, ratio / 100, ratio % 100,
+		   hash_size(&entries), pool_pages, max_pool_pages);
+}
+
+/* NOTE: [VM] LZ 압축 - LZ4 block 형식을 단순화한 것
+ * 시퀀스 = 토큰(상위 4비트 리터럴 길이, 하위 4비트 일치 길이 - 4) + 리터럴 + 2바이트 오프셋
+ * 길이가 15 이상이면 255 미만의 바이트가 나올 때까지 더해 가며 잇는다.
+ * 마지막 시퀀스는 리터럴만 있고 오프셋이 없다. */
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 10
+#define LZ_MAX_OFFSET 0xffff
+
+/* 위치 + 1 (0은 빈 칸) - zswap_lock으로 보호 */
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+
+static uint32_t
+lz_read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static unsigned
+lz_hash(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* 길이 LEN의 나머지 부분을 255 단위로 씀 - 자리가 없으면 NULL */
+static uint8_t *
+lz_put_length(uint8_t *op, uint8_t *oend, size_t len)
+{
+	for (; len >= 255; len -= 255)
+	{
+		if (op >= oend)
+			return NULL;
+		*op++ = 255;
+	}
+	if (op >= oend)
+		return NULL;
+	*op++ = len;
+	return op;
+}
+
+/* 시퀀스 하나를 씀 - MATCH_LEN이 0이면 마지막 시퀀스. 자리가 없으면 NULL */
+static uint8_t *
+lz_put_sequence(uint8_t *op, uint8_t *oend, const uint8_t *lit, size_t lit_len,
+				size_t offset, size_t match_len)
+{
+	size_t ml = match_len != 0 ? match_len - LZ_MIN_MATCH : 0;
+
+	if (op >= oend)
+		return NULL;
+	*op++ = (lit_len < 15 ? lit_len : 15) << 4 | (ml < 15 ? ml : 15);
+	if (lit_len >= 15 && (op = lz_put_length(op, oend, lit_len - 15)) == NULL)
+		return NULL;
+	if ((size_t)(oend - op) < lit_len)
+		return NULL;
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+	if (match_len == 0)
+		return op;
+
+	if (oend - op < 2)
+		return NULL;
+	*op++ = offset & 0xff;
+	*op++ = offset >> 8;
+	if (ml >= 15 && (op = lz_put_length(op, oend, ml - 15)) == NULL)
+		return NULL;
+	return op;
+}
+
+/**
+ * @brief SRC를 압축해 DST에 쓰는 함수
+ * 각 위치의 4바이트로 hash table을 찾아 앞에서 같은 내용이 나오면 (오프셋, 길이)로 바꾼다.
+ *
+ * @return size_t 압축된 길이, DST_CAP 안에 들어가지 않으면 0
+ */
+size_t lz_compress(const void *src_, size_t src_len, void *dst_, size_t dst_cap)
+{
+	const uint8_t *src = src_;
+	uint8_t *op = dst_, *oend = op + dst_cap;
+	size_t anchor = 0, i = 0;
+
+	ASSERT(src_len <= LZ_MAX_OFFSET);
+	memset(lz_table, 0, sizeof lz_table);
+
+	while (i + LZ_MIN_MATCH <= src_len)
+	{
+		uint32_t v = lz_read32(src + i);
+		unsigned h = lz_hash(v);
+		size_t ref = lz_table[h];
+		lz_table[h] = i + 1;
+
+		if (ref == 0 || lz_read32(src + ref - 1) != v)
+		{
+			i++;
+			continue;
+		}
+		ref--;
+
+		size_t len = LZ_MIN_MATCH;
+		while (i + len < src_len && src[ref + len] == src[i + len])
+			len++;
+
+		op = lz_put_sequence(op, oend, src + anchor, i - anchor, i - ref, len);
+		if (op == NULL)
+			return 0;
+		i += len;
+		anchor = i;
+	}
+
+	op = lz_put_sequence(op, oend, src + anchor, src_len - anchor, 0, 0);
+	return op != NULL ? op - (uint8_t *)dst_ : 0;
+}
+
+/* 255 단위로 이어진 길이를 읽어 *LEN에 더함 - 입력이 끝나면 false */
+static bool
+lz_get_length(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+	uint8_t b;
+	do
+	{
+		if (*ip >= iend)
+			return false;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/**
+ * @brief lz_compress()로 압축한 SRC를 풀어 DST에 쓰는 함수
+ *
+ * @return size_t 풀린 길이, 데이터가 잘못되었거나 DST_CAP을 넘으면 0
+ */
+size_t lz_decompress(const void *src_, size_t src_len, void *dst_, size_t dst_cap)
+{
+	const uint8_t *ip = src_, *iend = ip + src_len;
+	uint8_t *dst = dst_, *op = dst, *oend = dst + dst_cap;
+
+	while (ip < iend)
+	{
+		uint8_t token = *ip++;
+		size_t lit_len = token >> 4;
+		if (lit_len == 15 && !lz_get_length(&ip, iend, &lit_len))
+			return 0;
+		if ((size_t)(iend - ip) < lit_len || (size_t)(oend - op) < lit_len)
+			return 0;
+		memcpy(op, ip, lit_len);
+		ip += lit_len;
+		op += lit_len;
+		if (ip == iend)
+			return op - dst;
+
+		if (iend - ip < 2)
+			return 0;
+		size_t offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		size_t match_len = token & 15;
+		if (match_len == 15 && !lz_get_length(&ip, iend, &match_len))
+			return 0;
+		match_len += LZ_MIN_MATCH;
+		if (offset == 0 || offset > (size_t)(op - dst) || (size_t)(oend - op) < match_len)
+			return 0;
+
+		/* 겹칠 수 있으므로 한 바이트씩 복사 */
+		const uint8_t *ref = op - offset;
+		while (match_len-- > 0)
+			*op++ = *ref++;
+	}
+	return 0;
+}